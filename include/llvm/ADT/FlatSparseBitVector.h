@@ -0,0 +1,551 @@
+//===- llvm/ADT/FlatSparseBitVector.h - Array backed sparse bitset -*- C++ -*-//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the FlatSparseBitVector class, a sparse bitset that keeps
+// its non-zero elements in a sorted contiguous array.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_ADT_FLATSPARSEBITVECTOR_H
+#define LLVM_ADT_FLATSPARSEBITVECTOR_H
+
+#include "llvm/Support/DataTypes.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+namespace llvm {
+
+/// FlatSparseBitVector - A sparse bitset with the same interface as
+/// SparseBitVector.  Like SparseBitVector it only stores the ElementSize-bit
+/// elements that have bits set, but the elements live in a std::vector sorted
+/// by element index instead of in an ilist.
+///
+/// This trades the O(1) insertion of a fresh element in the middle of the set
+/// for a memmove, which is cheap for the small element counts seen in
+/// dataflow problems.  In return there is no per-element heap allocation, no
+/// pointer chasing, lookups are a binary search, and the set operations are
+/// linear merges over contiguous memory whose per-element word loops the
+/// compiler can vectorize.  Unions are merged in place from the back so that
+/// they never allocate more than the final size.
+template <unsigned ElementSize = 128>
+class FlatSparseBitVector {
+public:
+  typedef uint64_t BitWord;
+  enum {
+    BITWORD_SIZE = 64,
+    BITWORDS_PER_ELEMENT = (ElementSize + BITWORD_SIZE - 1) / BITWORD_SIZE,
+    BITS_PER_ELEMENT = ElementSize
+  };
+
+private:
+  struct Element {
+    // Index of Element in terms of where first bit starts.
+    unsigned Index;
+    BitWord Bits[BITWORDS_PER_ELEMENT];
+
+    explicit Element(unsigned Idx) : Index(Idx) {
+      for (unsigned i = 0; i < BITWORDS_PER_ELEMENT; ++i)
+        Bits[i] = 0;
+    }
+
+    bool empty() const {
+      BitWord Any = 0;
+      for (unsigned i = 0; i < BITWORDS_PER_ELEMENT; ++i)
+        Any |= Bits[i];
+      return Any == 0;
+    }
+
+    bool operator==(const Element &RHS) const {
+      if (Index != RHS.Index)
+        return false;
+      for (unsigned i = 0; i < BITWORDS_PER_ELEMENT; ++i)
+        if (Bits[i] != RHS.Bits[i])
+          return false;
+      return true;
+    }
+
+    // Return the index of the first set bit at or after Bit, or -1.
+    int findNext(unsigned Bit) const {
+      if (Bit >= BITS_PER_ELEMENT)
+        return -1;
+      unsigned WordPos = Bit / BITWORD_SIZE;
+      BitWord Copy = Bits[WordPos] & (~BitWord(0) << (Bit % BITWORD_SIZE));
+      if (Copy)
+        return WordPos * BITWORD_SIZE + CountTrailingZeros_64(Copy);
+      for (unsigned i = WordPos + 1; i < BITWORDS_PER_ELEMENT; ++i)
+        if (Bits[i])
+          return i * BITWORD_SIZE + CountTrailingZeros_64(Bits[i]);
+      return -1;
+    }
+  };
+
+  typedef std::vector<Element> ElementList;
+  ElementList Elements;
+
+  struct IndexLess {
+    bool operator()(const Element &E, unsigned Idx) const {
+      return E.Index < Idx;
+    }
+  };
+
+  // Return the position of the first element whose index is not less than
+  // ElementIndex.  Appending in order is the common case, so check the back
+  // first.  Short arrays are scanned linearly, longer ones are bisected.
+  unsigned findLowerBound(unsigned ElementIndex) const {
+    unsigned Size = Elements.size();
+    if (Size == 0 || Elements.back().Index < ElementIndex)
+      return Size;
+    if (Size <= 8) {
+      unsigned Pos = 0;
+      while (Elements[Pos].Index < ElementIndex)
+        ++Pos;
+      return Pos;
+    }
+    return std::lower_bound(Elements.begin(), Elements.end(), ElementIndex,
+                            IndexLess()) - Elements.begin();
+  }
+
+  // Return the element holding ElementIndex, or null.
+  const Element *findElement(unsigned ElementIndex) const {
+    unsigned Pos = findLowerBound(ElementIndex);
+    if (Pos == Elements.size() || Elements[Pos].Index != ElementIndex)
+      return 0;
+    return &Elements[Pos];
+  }
+
+  // Iterator to walk set bits in the bitmap.
+  class FlatSparseBitVectorIterator {
+    const ElementList *Elts;
+    // Current element and word inside of it.
+    unsigned ElementNumber;
+    unsigned WordNumber;
+    // Bits of the current word not visited yet.
+    BitWord Bits;
+    // Current bit number inside of our bitmap.
+    unsigned BitNumber;
+
+    // Move to the lowest set bit at or after the current word.
+    void advance() {
+      while (!Bits) {
+        if (++WordNumber == BITWORDS_PER_ELEMENT) {
+          WordNumber = 0;
+          if (++ElementNumber == Elts->size())
+            return;
+        }
+        Bits = (*Elts)[ElementNumber].Bits[WordNumber];
+      }
+      BitNumber = (*Elts)[ElementNumber].Index * ElementSize +
+                  WordNumber * BITWORD_SIZE + CountTrailingZeros_64(Bits);
+    }
+
+  public:
+    FlatSparseBitVectorIterator() : Elts(0), ElementNumber(0), WordNumber(0),
+                                    Bits(0), BitNumber(0) {}
+
+    FlatSparseBitVectorIterator(const ElementList *E, bool End)
+      : Elts(E), ElementNumber(End ? E->size() : 0), WordNumber(0), Bits(0),
+        BitNumber(0) {
+      if (ElementNumber == Elts->size())
+        return;
+      Bits = (*Elts)[0].Bits[0];
+      advance();
+    }
+
+    // Preincrement.
+    FlatSparseBitVectorIterator &operator++() {
+      // Clear the lowest set bit, which is the one we are at.
+      Bits &= Bits - 1;
+      advance();
+      return *this;
+    }
+
+    // Postincrement.
+    FlatSparseBitVectorIterator operator++(int) {
+      FlatSparseBitVectorIterator tmp = *this;
+      ++*this;
+      return tmp;
+    }
+
+    // Return the current set bit number.
+    unsigned operator*() const {
+      return BitNumber;
+    }
+
+    bool operator==(const FlatSparseBitVectorIterator &RHS) const {
+      bool AtEnd = ElementNumber == Elts->size();
+      bool RHSAtEnd = RHS.ElementNumber == RHS.Elts->size();
+      if (AtEnd || RHSAtEnd)
+        return AtEnd == RHSAtEnd;
+      return BitNumber == RHS.BitNumber;
+    }
+    bool operator!=(const FlatSparseBitVectorIterator &RHS) const {
+      return !(*this == RHS);
+    }
+  };
+
+public:
+  typedef FlatSparseBitVectorIterator iterator;
+
+  // Clear.
+  void clear() {
+    Elements.clear();
+  }
+
+  // Test, Reset, and Set a bit in the bitmap.
+  bool test(unsigned Idx) const {
+    const Element *E = findElement(Idx / ElementSize);
+    if (!E)
+      return false;
+    unsigned Bit = Idx % ElementSize;
+    return (E->Bits[Bit / BITWORD_SIZE] >> (Bit % BITWORD_SIZE)) & 1;
+  }
+
+  void reset(unsigned Idx) {
+    unsigned ElementIndex = Idx / ElementSize;
+    unsigned Pos = findLowerBound(ElementIndex);
+    if (Pos == Elements.size() || Elements[Pos].Index != ElementIndex)
+      return;
+    Element &E = Elements[Pos];
+    unsigned Bit = Idx % ElementSize;
+    E.Bits[Bit / BITWORD_SIZE] &= ~(BitWord(1) << (Bit % BITWORD_SIZE));
+
+    // When the element is zeroed out, delete it.
+    if (E.empty())
+      Elements.erase(Elements.begin() + Pos);
+  }
+
+  void set(unsigned Idx) {
+    unsigned ElementIndex = Idx / ElementSize;
+    unsigned Pos = findLowerBound(ElementIndex);
+    if (Pos == Elements.size() || Elements[Pos].Index != ElementIndex)
+      Elements.insert(Elements.begin() + Pos, Element(ElementIndex));
+    unsigned Bit = Idx % ElementSize;
+    Elements[Pos].Bits[Bit / BITWORD_SIZE] |= BitWord(1) << (Bit % BITWORD_SIZE);
+  }
+
+  bool test_and_set(unsigned Idx) {
+    if (test(Idx))
+      return false;
+    set(Idx);
+    return true;
+  }
+
+  bool operator!=(const FlatSparseBitVector &RHS) const {
+    return !(*this == RHS);
+  }
+
+  bool operator==(const FlatSparseBitVector &RHS) const {
+    return Elements.size() == RHS.Elements.size() &&
+           std::equal(Elements.begin(), Elements.end(), RHS.Elements.begin());
+  }
+
+  // Union our bitmap with the RHS and return true if we changed.
+  bool operator|=(const FlatSparseBitVector &RHS) {
+    if (this == &RHS || RHS.Elements.empty())
+      return false;
+
+    // Count the RHS elements we do not have yet.
+    unsigned NumNew = 0;
+    unsigned i = 0, j = 0, e1 = Elements.size(), e2 = RHS.Elements.size();
+    while (j != e2) {
+      if (i == e1) {
+        NumNew += e2 - j;
+        break;
+      }
+      if (Elements[i].Index < RHS.Elements[j].Index)
+        ++i;
+      else if (Elements[i].Index > RHS.Elements[j].Index)
+        ++NumNew, ++j;
+      else
+        ++i, ++j;
+    }
+
+    bool Changed = NumNew != 0;
+    // Merge from the back so that no element is overwritten before it is
+    // moved to its final position.
+    Elements.resize(e1 + NumNew, Element(0));
+    unsigned Out = e1 + NumNew;
+    i = e1;
+    j = e2;
+    while (j != 0) {
+      Element &Dst = Elements[--Out];
+      const Element &Src = RHS.Elements[j - 1];
+      if (i != 0 && Elements[i - 1].Index > Src.Index) {
+        Dst = Elements[--i];
+      } else if (i != 0 && Elements[i - 1].Index == Src.Index) {
+        const Element &Old = Elements[--i];
+        BitWord Diff = 0;
+        for (unsigned w = 0; w < BITWORDS_PER_ELEMENT; ++w) {
+          Diff |= Src.Bits[w] & ~Old.Bits[w];
+          Dst.Bits[w] = Old.Bits[w] | Src.Bits[w];
+        }
+        Dst.Index = Src.Index;
+        Changed |= Diff != 0;
+        --j;
+      } else {
+        Dst = Src;
+        --j;
+      }
+    }
+    // Once the RHS is exhausted the remaining prefix is already in place.
+    assert(Out == i && "Union merge lost track of elements");
+    return Changed;
+  }
+
+  // Intersect our bitmap with the RHS and return true if ours changed.
+  bool operator&=(const FlatSparseBitVector &RHS) {
+    if (this == &RHS)
+      return false;
+    bool Changed = false;
+    unsigned Out = 0, j = 0, e2 = RHS.Elements.size();
+    for (unsigned i = 0, e1 = Elements.size(); i != e1; ++i) {
+      Element &E = Elements[i];
+      while (j != e2 && RHS.Elements[j].Index < E.Index)
+        ++j;
+      if (j == e2 || RHS.Elements[j].Index != E.Index) {
+        // No such element in RHS; drop ours.
+        Changed = true;
+        continue;
+      }
+      const Element &R = RHS.Elements[j];
+      BitWord Diff = 0, Any = 0;
+      for (unsigned w = 0; w < BITWORDS_PER_ELEMENT; ++w) {
+        Diff |= E.Bits[w] & ~R.Bits[w];
+        E.Bits[w] &= R.Bits[w];
+        Any |= E.Bits[w];
+      }
+      Changed |= Diff != 0;
+      if (Any)
+        Elements[Out++] = E;
+    }
+    Elements.resize(Out, Element(0));
+    return Changed;
+  }
+
+  // Intersect our bitmap with the complement of the RHS and return true
+  // if ours changed.
+  bool intersectWithComplement(const FlatSparseBitVector &RHS) {
+    if (this == &RHS) {
+      bool Changed = !Elements.empty();
+      Elements.clear();
+      return Changed;
+    }
+    bool Changed = false;
+    unsigned Out = 0, j = 0, e2 = RHS.Elements.size();
+    for (unsigned i = 0, e1 = Elements.size(); i != e1; ++i) {
+      Element &E = Elements[i];
+      while (j != e2 && RHS.Elements[j].Index < E.Index)
+        ++j;
+      if (j != e2 && RHS.Elements[j].Index == E.Index) {
+        const Element &R = RHS.Elements[j];
+        BitWord Diff = 0, Any = 0;
+        for (unsigned w = 0; w < BITWORDS_PER_ELEMENT; ++w) {
+          Diff |= E.Bits[w] & R.Bits[w];
+          E.Bits[w] &= ~R.Bits[w];
+          Any |= E.Bits[w];
+        }
+        Changed |= Diff != 0;
+        if (!Any)
+          continue;
+      }
+      if (Out != i)
+        Elements[Out] = E;
+      ++Out;
+    }
+    Elements.resize(Out, Element(0));
+    return Changed;
+  }
+
+  bool intersectWithComplement(const FlatSparseBitVector *RHS) {
+    return intersectWithComplement(*RHS);
+  }
+
+  //  Three argument version of intersectWithComplement.
+  //  Result of RHS1 & ~RHS2 is stored into this bitmap.
+  void intersectWithComplement(const FlatSparseBitVector &RHS1,
+                               const FlatSparseBitVector &RHS2) {
+    ElementList Result;
+    Result.reserve(RHS1.Elements.size());
+    unsigned j = 0, e2 = RHS2.Elements.size();
+    for (unsigned i = 0, e1 = RHS1.Elements.size(); i != e1; ++i) {
+      const Element &L = RHS1.Elements[i];
+      while (j != e2 && RHS2.Elements[j].Index < L.Index)
+        ++j;
+      if (j == e2 || RHS2.Elements[j].Index != L.Index) {
+        Result.push_back(L);
+        continue;
+      }
+      const Element &R = RHS2.Elements[j];
+      Element E(L.Index);
+      for (unsigned w = 0; w < BITWORDS_PER_ELEMENT; ++w)
+        E.Bits[w] = L.Bits[w] & ~R.Bits[w];
+      if (!E.empty())
+        Result.push_back(E);
+    }
+    // Either operand may alias this bitmap, so only replace it at the end.
+    Elements.swap(Result);
+  }
+
+  void intersectWithComplement(const FlatSparseBitVector *RHS1,
+                               const FlatSparseBitVector *RHS2) {
+    intersectWithComplement(*RHS1, *RHS2);
+  }
+
+  bool intersects(const FlatSparseBitVector *RHS) const {
+    return intersects(*RHS);
+  }
+
+  // Return true if we share any bits in common with RHS
+  bool intersects(const FlatSparseBitVector &RHS) const {
+    unsigned i = 0, j = 0, e1 = Elements.size(), e2 = RHS.Elements.size();
+    while (i != e1 && j != e2) {
+      const Element &L = Elements[i], &R = RHS.Elements[j];
+      if (L.Index < R.Index) {
+        ++i;
+      } else if (L.Index > R.Index) {
+        ++j;
+      } else {
+        BitWord Common = 0;
+        for (unsigned w = 0; w < BITWORDS_PER_ELEMENT; ++w)
+          Common |= L.Bits[w] & R.Bits[w];
+        if (Common)
+          return true;
+        ++i, ++j;
+      }
+    }
+    return false;
+  }
+
+  // Return true iff all bits set in RHS are also set in this
+  // FlatSparseBitVector.  This matches SparseBitVector::contains.
+  bool contains(const FlatSparseBitVector &RHS) const {
+    unsigned i = 0, e1 = Elements.size();
+    for (unsigned j = 0, e2 = RHS.Elements.size(); j != e2; ++j) {
+      const Element &R = RHS.Elements[j];
+      while (i != e1 && Elements[i].Index < R.Index)
+        ++i;
+      if (i == e1 || Elements[i].Index != R.Index)
+        return false;
+      BitWord Missing = 0;
+      for (unsigned w = 0; w < BITWORDS_PER_ELEMENT; ++w)
+        Missing |= R.Bits[w] & ~Elements[i].Bits[w];
+      if (Missing)
+        return false;
+    }
+    return true;
+  }
+
+  // Return the first set bit in the bitmap.  Return -1 if no bits are set.
+  int find_first() const {
+    if (Elements.empty())
+      return -1;
+    const Element &First = Elements.front();
+    return First.Index * ElementSize + First.findNext(0);
+  }
+
+  // Return true if the FlatSparseBitVector is empty
+  bool empty() const {
+    return Elements.empty();
+  }
+
+  unsigned count() const {
+    unsigned BitCount = 0;
+    for (typename ElementList::const_iterator I = Elements.begin(),
+         E = Elements.end(); I != E; ++I)
+      for (unsigned w = 0; w < BITWORDS_PER_ELEMENT; ++w)
+        BitCount += CountPopulation_64(I->Bits[w]);
+    return BitCount;
+  }
+
+  iterator begin() const {
+    return iterator(&Elements, false);
+  }
+
+  iterator end() const {
+    return iterator(&Elements, true);
+  }
+};
+
+// Convenience functions to allow Or and And without dereferencing in the user
+// code.
+
+template <unsigned ElementSize>
+inline bool operator |=(FlatSparseBitVector<ElementSize> &LHS,
+                        const FlatSparseBitVector<ElementSize> *RHS) {
+  return LHS |= *RHS;
+}
+
+template <unsigned ElementSize>
+inline bool operator |=(FlatSparseBitVector<ElementSize> *LHS,
+                        const FlatSparseBitVector<ElementSize> &RHS) {
+  return LHS->operator|=(RHS);
+}
+
+template <unsigned ElementSize>
+inline bool operator &=(FlatSparseBitVector<ElementSize> *LHS,
+                        const FlatSparseBitVector<ElementSize> &RHS) {
+  return LHS->operator&=(RHS);
+}
+
+template <unsigned ElementSize>
+inline bool operator &=(FlatSparseBitVector<ElementSize> &LHS,
+                        const FlatSparseBitVector<ElementSize> *RHS) {
+  return LHS &= *RHS;
+}
+
+// Convenience functions for infix union, intersection, difference operators.
+
+template <unsigned ElementSize>
+inline FlatSparseBitVector<ElementSize>
+operator|(const FlatSparseBitVector<ElementSize> &LHS,
+          const FlatSparseBitVector<ElementSize> &RHS) {
+  FlatSparseBitVector<ElementSize> Result(LHS);
+  Result |= RHS;
+  return Result;
+}
+
+template <unsigned ElementSize>
+inline FlatSparseBitVector<ElementSize>
+operator&(const FlatSparseBitVector<ElementSize> &LHS,
+          const FlatSparseBitVector<ElementSize> &RHS) {
+  FlatSparseBitVector<ElementSize> Result(LHS);
+  Result &= RHS;
+  return Result;
+}
+
+template <unsigned ElementSize>
+inline FlatSparseBitVector<ElementSize>
+operator-(const FlatSparseBitVector<ElementSize> &LHS,
+          const FlatSparseBitVector<ElementSize> &RHS) {
+  FlatSparseBitVector<ElementSize> Result;
+  Result.intersectWithComplement(LHS, RHS);
+  return Result;
+}
+
+// Dump a FlatSparseBitVector to a stream
+template <unsigned ElementSize>
+void dump(const FlatSparseBitVector<ElementSize> &LHS, raw_ostream &out) {
+  out << "[";
+
+  typename FlatSparseBitVector<ElementSize>::iterator bi = LHS.begin(),
+    be = LHS.end();
+  if (bi != be) {
+    out << *bi;
+    for (++bi; bi != be; ++bi) {
+      out << " " << *bi;
+    }
+  }
+  out << "]\n";
+}
+} // end namespace llvm
+
+#endif
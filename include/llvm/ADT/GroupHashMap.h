@@ -0,0 +1,470 @@
+//===- llvm/ADT/GroupHashMap.h - Group-probed hash table --------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the GroupHashMap class, an open addressing hash table
+// which keeps one control byte per bucket next to the buckets themselves.
+// A control byte is either "empty", "deleted", or holds 7 bits of the hash of
+// the key in the bucket.  Buckets are probed in groups of 16: one compare of
+// the group's control bytes (a single SSE2 instruction where available)
+// finds the few buckets worth comparing keys in, and a group with an empty
+// byte ends the probe.
+//
+// Unlike DenseMap, no key values are reserved as empty or tombstone markers,
+// so only the getHashValue and isEqual members of KeyInfoT are used.  Like
+// DenseMap, inserting or erasing invalidates iterators.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_ADT_GROUPHASHMAP_H
+#define LLVM_ADT_GROUPHASHMAP_H
+
+#include "llvm/ADT/DenseMapInfo.h"
+#include "llvm/ADT/Hashing.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/type_traits.h"
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <new>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace llvm {
+
+template<typename KeyT, typename ValueT, typename KeyInfoT, bool IsConst>
+class GroupHashMapIterator;
+
+namespace detail {
+
+/// GroupHashMapControl - Operations on the control bytes of a group.
+struct GroupHashMapControl {
+  enum {
+    GroupSize = 16,
+    Empty = 0x80,
+    Deleted = 0xFE
+    // Anything with the top bit clear is the hash of a full bucket.
+  };
+
+  /// match - Return a mask with bit I set if control byte I of the group
+  /// starting at Ctrl equals Byte.
+  static unsigned match(const unsigned char *Ctrl, unsigned char Byte) {
+#if defined(__SSE2__)
+    __m128i Group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Ctrl));
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(Group,
+                                            _mm_set1_epi8((char)Byte)));
+#else
+    unsigned Mask = 0;
+    for (unsigned i = 0; i != GroupSize; ++i)
+      if (Ctrl[i] == Byte)
+        Mask |= 1U << i;
+    return Mask;
+#endif
+  }
+
+  /// matchEmptyOrDeleted - Return a mask with bit I set if bucket I of the
+  /// group starting at Ctrl is free.  Both markers have the top bit set.
+  static unsigned matchEmptyOrDeleted(const unsigned char *Ctrl) {
+#if defined(__SSE2__)
+    __m128i Group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Ctrl));
+    return _mm_movemask_epi8(Group);
+#else
+    unsigned Mask = 0;
+    for (unsigned i = 0; i != GroupSize; ++i)
+      if (Ctrl[i] & 0x80)
+        Mask |= 1U << i;
+    return Mask;
+#endif
+  }
+};
+
+} // end namespace detail
+
+template<typename KeyT, typename ValueT,
+         typename KeyInfoT = DenseMapInfo<KeyT> >
+class GroupHashMap {
+  typedef detail::GroupHashMapControl Control;
+  typedef std::pair<KeyT, ValueT> BucketT;
+
+  /// Ctrl - One control byte per bucket.
+  unsigned char *Ctrl;
+  BucketT *Buckets;
+  unsigned NumGroups;
+  unsigned NumEntries;
+  unsigned NumTombstones;
+
+public:
+  typedef KeyT key_type;
+  typedef ValueT mapped_type;
+  typedef BucketT value_type;
+
+  typedef GroupHashMapIterator<KeyT, ValueT, KeyInfoT, false> iterator;
+  typedef GroupHashMapIterator<KeyT, ValueT, KeyInfoT, true> const_iterator;
+
+  /// Create a map large enough to hold NumInitEntries entries without
+  /// growing.
+  explicit GroupHashMap(unsigned NumInitEntries = 0)
+    : Ctrl(0), Buckets(0), NumGroups(0), NumEntries(0), NumTombstones(0) {
+    reserve(NumInitEntries);
+  }
+
+  GroupHashMap(const GroupHashMap &Other)
+    : Ctrl(0), Buckets(0), NumGroups(0), NumEntries(0), NumTombstones(0) {
+    reserve(Other.size());
+    for (const_iterator I = Other.begin(), E = Other.end(); I != E; ++I)
+      insertNew(*I);
+  }
+
+  ~GroupHashMap() {
+    destroyAll();
+    operator delete(Ctrl);
+    operator delete(Buckets);
+  }
+
+  GroupHashMap &operator=(const GroupHashMap &Other) {
+    if (&Other != this) {
+      GroupHashMap Tmp(Other);
+      swap(Tmp);
+    }
+    return *this;
+  }
+
+  void swap(GroupHashMap &RHS) {
+    std::swap(Ctrl, RHS.Ctrl);
+    std::swap(Buckets, RHS.Buckets);
+    std::swap(NumGroups, RHS.NumGroups);
+    std::swap(NumEntries, RHS.NumEntries);
+    std::swap(NumTombstones, RHS.NumTombstones);
+  }
+
+  iterator begin() {
+    return iterator(Ctrl, Buckets, Buckets + getNumBuckets());
+  }
+  iterator end() {
+    return iterator(0, Buckets + getNumBuckets(), Buckets + getNumBuckets());
+  }
+  const_iterator begin() const {
+    return const_iterator(Ctrl, Buckets, Buckets + getNumBuckets());
+  }
+  const_iterator end() const {
+    return const_iterator(0, Buckets + getNumBuckets(),
+                          Buckets + getNumBuckets());
+  }
+
+  bool empty() const { return NumEntries == 0; }
+  unsigned size() const { return NumEntries; }
+
+  /// reserve - Grow the table so that it can hold N entries without growing
+  /// again.
+  void reserve(unsigned N) {
+    unsigned NeededGroups = getMinGroupsFor(N);
+    if (NeededGroups > NumGroups)
+      rehash(NeededGroups);
+  }
+
+  void clear() {
+    if (NumEntries == 0 && NumTombstones == 0) return;
+    destroyAll();
+    std::memset(Ctrl, Control::Empty, getNumBuckets());
+    NumEntries = 0;
+    NumTombstones = 0;
+  }
+
+  /// count - Return 1 if the specified key is in the map, 0 otherwise.
+  unsigned count(const KeyT &Key) const {
+    return lookupBucket(Key) != getNumBuckets() ? 1 : 0;
+  }
+
+  iterator find(const KeyT &Key) {
+    unsigned Idx = lookupBucket(Key);
+    if (Idx == getNumBuckets())
+      return end();
+    return iterator(Ctrl + Idx, Buckets + Idx, Buckets + getNumBuckets());
+  }
+  const_iterator find(const KeyT &Key) const {
+    unsigned Idx = lookupBucket(Key);
+    if (Idx == getNumBuckets())
+      return end();
+    return const_iterator(Ctrl + Idx, Buckets + Idx,
+                          Buckets + getNumBuckets());
+  }
+
+  /// lookup - Return the entry for the specified key, or a default
+  /// constructed value if no such entry exists.
+  ValueT lookup(const KeyT &Key) const {
+    unsigned Idx = lookupBucket(Key);
+    if (Idx == getNumBuckets())
+      return ValueT();
+    return Buckets[Idx].second;
+  }
+
+  // Inserts key,value pair into the map if the key isn't already in the map.
+  // If the key is already in the map, it returns false and doesn't update the
+  // value.
+  std::pair<iterator, bool> insert(const std::pair<KeyT, ValueT> &KV) {
+    unsigned Idx = lookupBucket(KV.first);
+    if (Idx != getNumBuckets())
+      return std::make_pair(iterator(Ctrl + Idx, Buckets + Idx,
+                                     Buckets + getNumBuckets()), false);
+    Idx = insertNew(KV);
+    return std::make_pair(iterator(Ctrl + Idx, Buckets + Idx,
+                                   Buckets + getNumBuckets()), true);
+  }
+
+  /// insert - Range insertion of pairs.
+  template<typename InputIt>
+  void insert(InputIt I, InputIt E) {
+    for (; I != E; ++I)
+      insert(*I);
+  }
+
+  bool erase(const KeyT &Key) {
+    unsigned Idx = lookupBucket(Key);
+    if (Idx == getNumBuckets())
+      return false;
+    eraseBucket(Idx);
+    return true;
+  }
+  void erase(iterator I) {
+    eraseBucket(I.Ptr - Buckets);
+  }
+
+  value_type &FindAndConstruct(const KeyT &Key) {
+    unsigned Idx = lookupBucket(Key);
+    if (Idx == getNumBuckets())
+      Idx = insertNew(std::make_pair(Key, ValueT()));
+    return Buckets[Idx];
+  }
+
+  ValueT &operator[](const KeyT &Key) {
+    return FindAndConstruct(Key).second;
+  }
+
+  /// getMemorySize - Return the approximate size (in bytes) of the actual map.
+  /// This is just the raw memory used by the map, not the memory used by the
+  /// keys or values it refers to.
+  size_t getMemorySize() const {
+    return getNumBuckets() * (sizeof(BucketT) + 1);
+  }
+
+private:
+  friend class GroupHashMapIterator<KeyT, ValueT, KeyInfoT, false>;
+  friend class GroupHashMapIterator<KeyT, ValueT, KeyInfoT, true>;
+
+  unsigned getNumBuckets() const {
+    return NumGroups * Control::GroupSize;
+  }
+
+  /// getMinGroupsFor - Return the number of groups needed to hold N entries
+  /// while keeping the table at most 7/8 full.
+  static unsigned getMinGroupsFor(unsigned N) {
+    if (N == 0)
+      return 0;
+    unsigned NeededBuckets = N + N / 7 + 1;
+    unsigned Groups = (NeededBuckets + Control::GroupSize - 1) /
+                      Control::GroupSize;
+    return unsigned(NextPowerOf2(Groups - 1));
+  }
+
+  /// getHash - Mix the hash KeyInfoT provides.  DenseMapInfo hashes are
+  /// often weak in their low bits, which pick the group, and in their high
+  /// bits, which are kept in the control byte.
+  static size_t getHash(const KeyT &Key) {
+    return hash_value(KeyInfoT::getHashValue(Key));
+  }
+
+  /// lookupBucket - Return the index of the bucket holding Key, or
+  /// getNumBuckets() if it is not in the map.
+  unsigned lookupBucket(const KeyT &Key) const {
+    if (NumGroups == 0)
+      return 0;
+
+    size_t Hash = getHash(Key);
+    unsigned char H2 = Hash & 0x7F;
+    unsigned GroupMask = NumGroups - 1;
+    unsigned Group = (Hash >> 7) & GroupMask;
+    for (unsigned Probe = 1; ; ++Probe) {
+      const unsigned char *GroupCtrl = Ctrl + Group * Control::GroupSize;
+      for (unsigned Mask = Control::match(GroupCtrl, H2); Mask;
+           Mask &= Mask - 1) {
+        unsigned Idx = Group * Control::GroupSize + CountTrailingZeros_32(Mask);
+        if (KeyInfoT::isEqual(Buckets[Idx].first, Key))
+          return Idx;
+      }
+      // A group with an empty bucket ends every probe sequence through it.
+      if (Control::match(GroupCtrl, Control::Empty))
+        return getNumBuckets();
+      // Triangular steps visit every group of a power of two sized table.
+      Group = (Group + Probe) & GroupMask;
+    }
+  }
+
+  /// findFreeBucket - Return the first empty or deleted bucket on the probe
+  /// sequence for Hash.
+  unsigned findFreeBucket(size_t Hash) const {
+    unsigned GroupMask = NumGroups - 1;
+    unsigned Group = (Hash >> 7) & GroupMask;
+    for (unsigned Probe = 1; ; ++Probe) {
+      const unsigned char *GroupCtrl = Ctrl + Group * Control::GroupSize;
+      if (unsigned Mask = Control::matchEmptyOrDeleted(GroupCtrl))
+        return Group * Control::GroupSize + CountTrailingZeros_32(Mask);
+      Group = (Group + Probe) & GroupMask;
+    }
+  }
+
+  /// insertNew - Insert KV, whose key is known not to be in the map, and
+  /// return the index of its bucket.
+  unsigned insertNew(const value_type &KV) {
+    // Keep at least one empty bucket in every probe sequence by growing, or
+    // rehashing in place to drop tombstones, once the table is 7/8 full.
+    unsigned NumBuckets = getNumBuckets();
+    if ((NumEntries + NumTombstones + 1) * 8 > NumBuckets * 7)
+      rehash(std::max(getMinGroupsFor(NumEntries + 1), NumGroups));
+
+    size_t Hash = getHash(KV.first);
+    unsigned Idx = findFreeBucket(Hash);
+    if (Ctrl[Idx] == Control::Deleted)
+      --NumTombstones;
+    Ctrl[Idx] = Hash & 0x7F;
+    new (&Buckets[Idx]) value_type(KV);
+    ++NumEntries;
+    return Idx;
+  }
+
+  void eraseBucket(unsigned Idx) {
+    Buckets[Idx].~value_type();
+    --NumEntries;
+
+    // If the group already has an empty bucket, no probe sequence continues
+    // past it, so this bucket can be made empty rather than a tombstone.
+    unsigned char *GroupCtrl =
+      Ctrl + (Idx & ~unsigned(Control::GroupSize - 1));
+    if (Control::match(GroupCtrl, Control::Empty)) {
+      Ctrl[Idx] = Control::Empty;
+    } else {
+      Ctrl[Idx] = Control::Deleted;
+      ++NumTombstones;
+    }
+  }
+
+  void destroyAll() {
+    if (isPodLike<KeyT>::value && isPodLike<ValueT>::value)
+      return;
+    for (unsigned i = 0, e = getNumBuckets(); i != e; ++i)
+      if (!(Ctrl[i] & 0x80))
+        Buckets[i].~value_type();
+  }
+
+  /// rehash - Move every entry into a new table of NewNumGroups groups.
+  void rehash(unsigned NewNumGroups) {
+    unsigned char *OldCtrl = Ctrl;
+    BucketT *OldBuckets = Buckets;
+    unsigned OldNumBuckets = getNumBuckets();
+
+    NumGroups = NewNumGroups;
+    unsigned NumBuckets = getNumBuckets();
+    Ctrl = static_cast<unsigned char*>(operator new(NumBuckets));
+    std::memset(Ctrl, Control::Empty, NumBuckets);
+    Buckets = static_cast<BucketT*>(operator new(sizeof(BucketT) *
+                                                 NumBuckets));
+    NumTombstones = 0;
+
+    for (unsigned i = 0; i != OldNumBuckets; ++i) {
+      if (OldCtrl[i] & 0x80)
+        continue;
+      size_t Hash = getHash(OldBuckets[i].first);
+      unsigned Idx = findFreeBucket(Hash);
+      Ctrl[Idx] = Hash & 0x7F;
+      new (&Buckets[Idx]) value_type(OldBuckets[i]);
+      OldBuckets[i].~value_type();
+    }
+
+    operator delete(OldCtrl);
+    operator delete(OldBuckets);
+  }
+};
+
+template<typename KeyT, typename ValueT, typename KeyInfoT, bool IsConst>
+class GroupHashMapIterator {
+  typedef std::pair<KeyT, ValueT> Bucket;
+  typedef GroupHashMapIterator<KeyT, ValueT, KeyInfoT, true> ConstIterator;
+  friend class GroupHashMapIterator<KeyT, ValueT, KeyInfoT, true>;
+  friend class GroupHashMap<KeyT, ValueT, KeyInfoT>;
+public:
+  typedef ptrdiff_t difference_type;
+  typedef typename conditional<IsConst, const Bucket, Bucket>::type value_type;
+  typedef value_type *pointer;
+  typedef value_type &reference;
+  typedef std::forward_iterator_tag iterator_category;
+private:
+  const unsigned char *Ctrl;
+  pointer Ptr, End;
+public:
+  GroupHashMapIterator() : Ctrl(0), Ptr(0), End(0) {}
+
+  /// Create an iterator at Pos, whose control byte is at C, advancing to the
+  /// first full bucket.  A null C is the end iterator.
+  GroupHashMapIterator(const unsigned char *C, pointer Pos, pointer E)
+    : Ctrl(C), Ptr(Pos), End(E) {
+    if (Ctrl) AdvancePastFreeBuckets();
+  }
+
+  // If IsConst is true this is a converting constructor from iterator to
+  // const_iterator and the default copy constructor is used.
+  // Otherwise this is a copy constructor for iterator.
+  GroupHashMapIterator(const GroupHashMapIterator<KeyT, ValueT,
+                                                  KeyInfoT, false> &I)
+    : Ctrl(I.Ctrl), Ptr(I.Ptr), End(I.End) {}
+
+  reference operator*() const {
+    return *Ptr;
+  }
+  pointer operator->() const {
+    return Ptr;
+  }
+
+  bool operator==(const ConstIterator &RHS) const {
+    return Ptr == RHS.operator->();
+  }
+  bool operator!=(const ConstIterator &RHS) const {
+    return Ptr != RHS.operator->();
+  }
+
+  inline GroupHashMapIterator& operator++() {  // Preincrement
+    ++Ptr;
+    ++Ctrl;
+    AdvancePastFreeBuckets();
+    return *this;
+  }
+  GroupHashMapIterator operator++(int) {  // Postincrement
+    GroupHashMapIterator tmp = *this; ++*this; return tmp;
+  }
+
+private:
+  void AdvancePastFreeBuckets() {
+    while (Ptr != End && (*Ctrl & 0x80)) {
+      ++Ptr;
+      ++Ctrl;
+    }
+  }
+};
+
+template<typename KeyT, typename ValueT, typename KeyInfoT>
+static inline size_t
+capacity_in_bytes(const GroupHashMap<KeyT, ValueT, KeyInfoT> &X) {
+  return X.getMemorySize();
+}
+
+} // end namespace llvm
+
+#endif
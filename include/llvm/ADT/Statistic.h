@@ -28,6 +28,7 @@
 
 #include "llvm/Support/Atomic.h"
 #include "llvm/Support/Valgrind.h"
+#include <vector>
 
 namespace llvm {
 class raw_ostream;
@@ -57,19 +58,15 @@ public:
   }
 
   const Statistic &operator++() {
-    // FIXME: This function and all those that follow carefully use an
-    // atomic operation to update the value safely in the presence of
-    // concurrent accesses, but not to read the return value, so the
-    // return value is not thread safe.
     sys::AtomicIncrement(&Value);
     return init();
   }
 
+  // The postfix forms derive the old value from the result of the atomic
+  // operation, so it is consistent even if other threads update the counter.
   unsigned operator++(int) {
     init();
-    unsigned OldValue = Value;
-    sys::AtomicIncrement(&Value);
-    return OldValue;
+    return sys::AtomicIncrement(&Value) - 1;
   }
 
   const Statistic &operator--() {
@@ -79,9 +76,7 @@ public:
 
   unsigned operator--(int) {
     init();
-    unsigned OldValue = Value;
-    sys::AtomicDecrement(&Value);
-    return OldValue;
+    return sys::AtomicDecrement(&Value) + 1;
   }
 
   const Statistic &operator+=(const unsigned &V) {
@@ -134,6 +129,16 @@ void PrintStatistics();
 /// \brief Print statistics to the given output stream.
 void PrintStatistics(raw_ostream &OS);
 
+/// \brief Print statistics to the given output stream as a JSON array of
+/// objects with "name", "desc" and "value" members.
+void PrintStatisticsJSON(raw_ostream &OS);
+
+/// \brief Fill in Stats with every statistic registered so far, sorted by
+/// name and then by description.  Only statistics bumped while statistics
+/// are enabled are registered.  The values are read when the caller asks
+/// for them, so this can be used to poll the counters of a running program.
+void GetStatistics(std::vector<const Statistic*> &Stats);
+
 } // End llvm namespace
 
 #endif
@@ -17,6 +17,7 @@
 #include "llvm/Function.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/ValueMap.h"
 #include "llvm/Analysis/CodeMetrics.h"
 #include <cassert>
@@ -103,14 +104,53 @@ namespace llvm {
   };
 
   /// InlineCostAnalyzer - Cost analyzer used by inliner.
+  ///
+  /// The analyzer keeps a per-callee cache of cost summaries. Each summary is
+  /// bucketed by the features of the call site which can influence the walk of
+  /// the callee body: the threshold, the constant (or constant-offset pointer)
+  /// arguments, and a handful of caller properties. Call sites which share a
+  /// bucket reuse the summary instead of re-simplifying the callee. The cache
+  /// has no way to observe changes to a function body, so clients must call
+  /// resetCachedCostInfo whenever a callee is modified or deleted.
   class InlineCostAnalyzer {
     // TargetData if available, or null.
     const TargetData *TD;
 
+    /// \brief A cost summary for one argument-specialization bucket.
+    struct CachedCost {
+      SmallVector<uintptr_t, 8> Key;
+      /// Handles on the constants Key refers to by address.  Once one of them
+      /// is destroyed its address may be reused by another constant, so the
+      /// entry must no longer match.
+      SmallVector<WeakVH, 4> Constants;
+      InlineCost Cost;
+
+      CachedCost(const SmallVectorImpl<uintptr_t> &Key,
+                 const SmallVectorImpl<Constant *> &KeyConstants,
+                 InlineCost Cost)
+        : Key(Key.begin(), Key.end()),
+          Constants(KeyConstants.begin(), KeyConstants.end()), Cost(Cost) {}
+
+      bool isStale() const {
+        for (unsigned i = 0, e = Constants.size(); i != e; ++i)
+          if (!Constants[i])
+            return true;
+        return false;
+      }
+    };
+    typedef std::vector<CachedCost> CachedCostList;
+
+    /// CachedCosts - The cost summaries computed so far, keyed by callee.
+    DenseMap<const Function *, CachedCostList> CachedCosts;
+
   public:
     InlineCostAnalyzer(): TD(0) {}
 
-    void setTargetData(const TargetData *TData) { TD = TData; }
+    void setTargetData(const TargetData *TData) {
+      if (TD != TData)
+        clearCachedCostInfo();
+      TD = TData;
+    }
 
     /// \brief Get an InlineCost object representing the cost of inlining this
     /// callsite.
@@ -129,6 +169,16 @@ namespace llvm {
     //  Note: This is used by out-of-tree passes, please do not remove without
     //  adding a replacement API.
     InlineCost getInlineCost(CallSite CS, Function *Callee, int Threshold);
+
+    /// resetCachedCostInfo - Forget the cost summaries computed for the
+    /// specified callee. This must be called when the body of the function is
+    /// changed, and before it is deleted.
+    void resetCachedCostInfo(const Function *Callee) {
+      CachedCosts.erase(Callee);
+    }
+
+    /// clearCachedCostInfo - Forget all cached cost summaries.
+    void clearCachedCostInfo() { CachedCosts.clear(); }
   };
 }
 
@@ -31,6 +31,8 @@
 #include "llvm/Support/ConstantRange.h"
 #include "llvm/ADT/FoldingSet.h"
 #include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
 #include <map>
 
 namespace llvm {
@@ -356,13 +358,26 @@ namespace llvm {
 
     /// ValuesAtScopes - This map contains entries for all the expressions
     /// that we attempt to compute getSCEVAtScope information for, which can
-    /// be expensive in extreme cases.
+    /// be expensive in extreme cases.  Most expressions are only queried at
+    /// one or two scopes, so the per-expression entries are kept in small
+    /// inline vectors rather than node-based maps.
     DenseMap<const SCEV *,
-             std::map<const Loop *, const SCEV *> > ValuesAtScopes;
+             SmallVector<std::pair<const Loop *, const SCEV *>, 2> >
+      ValuesAtScopes;
 
     /// LoopDispositions - Memoized computeLoopDisposition results.
     DenseMap<const SCEV *,
-             std::map<const Loop *, LoopDisposition> > LoopDispositions;
+             SmallVector<std::pair<const Loop *, LoopDisposition>, 2> >
+      LoopDispositions;
+
+    /// ScopeUsers - The expressions with an entry for each loop in
+    /// ValuesAtScopes or LoopDispositions, so that forgetLoop can drop them
+    /// without scanning either table.
+    DenseMap<const Loop *, SmallPtrSet<const SCEV *, 8> > ScopeUsers;
+
+    /// forgetScopeEntries - Drop the ValuesAtScopes and LoopDispositions
+    /// entries computed at the scope of L.
+    void forgetScopeEntries(const Loop *L);
 
     /// computeLoopDisposition - Compute a LoopDisposition value.
     LoopDisposition computeLoopDisposition(const SCEV *S, const Loop *L);
@@ -778,7 +793,9 @@ namespace llvm {
 
     /// forgetLoop - This method should be called by the client when it has
     /// changed a loop in a way that may effect ScalarEvolution's ability to
-    /// compute a trip count, or if the loop is deleted.
+    /// compute a trip count, or if the loop is deleted.  This also frees the
+    /// values and dispositions cached at the scope of the loop and its
+    /// subloops.
     void forgetLoop(const Loop *L);
 
     /// forgetValue - This method should be called by the client when it has
@@ -41,13 +41,25 @@ enum VerifierFailureAction {
   ReturnStatusAction    ///< verifyModule will just return true
 };
 
+/// @brief An enumeration to specify how thoroughly function bodies are checked.
+///
+/// Structural verification skips the checks which need a dominator tree, such
+/// as whether every definition dominates its uses.  It is meant for clients
+/// like JITs that verify each function as it is built and cannot afford to
+/// compute dominators every time.
+enum VerifierLevel {
+  FullVerification,      ///< Run every check
+  StructuralVerification ///< Skip the checks which need dominator information
+};
+
 /// @brief Create a verifier pass.
 ///
 /// Check a module or function for validity.  When the pass is used, the
 /// action indicated by the \p action argument will be used if errors are
 /// found.
 FunctionPass *createVerifierPass(
-  VerifierFailureAction action = AbortProcessAction ///< Action to take
+  VerifierFailureAction action = AbortProcessAction, ///< Action to take
+  VerifierLevel level = FullVerification ///< Checks to run
 );
 
 /// @brief Check a module for errors.
@@ -55,19 +67,22 @@ FunctionPass *createVerifierPass(
 /// If there are no errors, the function returns false. If an error is found,
 /// the action taken depends on the \p action parameter.
 /// This should only be used for debugging, because it plays games with
-/// PassManagers and stuff.
+/// PassManagers and stuff.  With ReturnStatusAction and no \p ErrorInfo,
+/// verification stops at the first broken function.
 
 bool verifyModule(
   const Module &M,  ///< The module to be verified
   VerifierFailureAction action = AbortProcessAction, ///< Action to take
-  std::string *ErrorInfo = 0      ///< Information about failures.
+  std::string *ErrorInfo = 0,     ///< Information about failures.
+  VerifierLevel level = FullVerification ///< Checks to run
 );
 
 // verifyFunction - Check a function for errors, useful for use when debugging a
 // pass.
 bool verifyFunction(
   const Function &F,  ///< The function to be verified
-  VerifierFailureAction action = AbortProcessAction ///< Action to take
+  VerifierFailureAction action = AbortProcessAction, ///< Action to take
+  VerifierLevel level = FullVerification ///< Checks to run
 );
 
 } // End llvm namespace
@@ -17,8 +17,11 @@
 #ifndef LLVM_ASSEMBLY_WRITER_H
 #define LLVM_ASSEMBLY_WRITER_H
 
+#include <string>
+
 namespace llvm {
 
+class AssemblyAnnotationWriter;
 class Module;
 class Value;
 class raw_ostream;
@@ -32,6 +35,16 @@ class raw_ostream;
 void WriteAsOperand(raw_ostream &, const Value *, bool PrintTy = true,
                     const Module *Context = 0);
 
+// WriteModuleLazily - Print the module like Module::print, but read in the
+// body of each lazily loaded function just before it is printed and drop it
+// again afterwards, so that only one body is in memory at a time.  Each body is
+// read twice, once to find the types it uses and once to print it.  Returns
+// true and fills in ErrInfo if a function body could not be read.
+//
+bool WriteModuleLazily(raw_ostream &OS, Module *M,
+                       AssemblyAnnotationWriter *AAW = 0,
+                       std::string *ErrInfo = 0);
+
 } // End llvm namespace
 
 #endif
@@ -267,6 +267,24 @@ public:
     BlockScope.pop_back();
   }
 
+  /// EmitSubblock - Emit a block that another writer wrote at its top level,
+  /// e.g. to encode blocks into buffers of their own and splice them together
+  /// in order.  The other writer needs the same BLOCKINFO (see CopyBlockInfo)
+  /// and must have entered the block with the same ID and code width.  Blocks
+  /// end on a word boundary, so only the header is encoded again for the code
+  /// width of the current block; the rest is copied as is.
+  void EmitSubblock(unsigned BlockID, unsigned CodeLen,
+                    const SmallVectorImpl<char> &Block) {
+    // At the top level, the header up to the size field takes one word.
+    assert(Block.size() >= 8 && (Block.size() & 3) == 0 &&
+           "Not a complete block!");
+    EmitCode(bitc::ENTER_SUBBLOCK);
+    EmitVBR(BlockID, bitc::BlockIDWidth);
+    EmitVBR(CodeLen, bitc::CodeLenWidth);
+    FlushToWord();
+    Out.append(Block.begin() + 4, Block.end());
+  }
+
   //===--------------------------------------------------------------------===//
   // Record Emission
   //===--------------------------------------------------------------------===//
@@ -540,6 +558,21 @@ public:
 
     return Info.Abbrevs.size()-1+bitc::FIRST_APPLICATION_ABBREV;
   }
+
+  /// CopyBlockInfo - Take on the abbreviations that the BLOCKINFO_BLOCK of
+  /// another writer defined, without emitting them again.
+  void CopyBlockInfo(const BitstreamWriter &From) {
+    unsigned NumRecords = static_cast<unsigned>(From.BlockInfoRecords.size());
+    for (unsigned i = 0; i != NumRecords; ++i) {
+      const BlockInfo &FromInfo = From.BlockInfoRecords[i];
+      BlockInfo &Info = getOrCreateBlockInfo(FromInfo.BlockID);
+      for (unsigned j = 0, je = static_cast<unsigned>(FromInfo.Abbrevs.size());
+           j != je; ++j) {
+        Info.Abbrevs.push_back(FromInfo.Abbrevs[j]);
+        FromInfo.Abbrevs[j]->addRef();
+      }
+    }
+  }
 };
 
 
@@ -26,10 +26,13 @@ namespace llvm {
   class raw_ostream;
 
   /// getLazyBitcodeModule - Read the header of the specified bitcode buffer
-  /// and prepare for lazy deserialization of function bodies.  If successful,
-  /// this takes ownership of 'buffer' and returns a non-null pointer.  On
-  /// error, this returns null, *does not* take ownership of Buffer, and fills
-  /// in *ErrMsg with an error description if ErrMsg is non-null.
+  /// and prepare for lazy deserialization of function bodies.  Module-level
+  /// metadata is also read lazily: a node is only built once a materialized
+  /// function, a named metadata node or another node refers to it.  If
+  /// successful, this takes ownership of 'buffer' and returns a non-null
+  /// pointer.  On error, this returns null, *does not* take ownership of
+  /// Buffer, and fills in *ErrMsg with an error description if ErrMsg is
+  /// non-null.
   Module *getLazyBitcodeModule(MemoryBuffer *Buffer,
                                LLVMContext &Context,
                                std::string *ErrMsg = 0);
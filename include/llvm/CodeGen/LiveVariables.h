@@ -35,10 +35,10 @@
 #include "llvm/Target/TargetRegisterInfo.h"
 #include "llvm/ADT/BitVector.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/FlatSparseBitVector.h"
 #include "llvm/ADT/IndexedMap.h"
 #include "llvm/ADT/SmallSet.h"
 #include "llvm/ADT/SmallVector.h"
-#include "llvm/ADT/SparseBitVector.h"
 
 namespace llvm {
 
@@ -83,7 +83,7 @@ public:
     /// through.  This is a bit set which uses the basic block number as an
     /// index.
     ///
-    SparseBitVector<> AliveBlocks;
+    FlatSparseBitVector<> AliveBlocks;
 
     /// Kills - List of MachineInstruction's which are the last use of this
     /// virtual register (kill it) in their basic block.
@@ -124,7 +124,7 @@ private:
   /// PHIJoins - list of virtual registers that are PHI joins. These registers
   /// may have multiple definitions, and they require special handling when
   /// building live intervals.
-  SparseBitVector<> PHIJoins;
+  FlatSparseBitVector<> PHIJoins;
 
   /// ReservedRegisters - This vector keeps track of which registers
   /// are reserved register which are not allocatable by the target machine.
@@ -16,6 +16,7 @@
 #define LLVM_LLVMCONTEXT_H
 
 #include "llvm/Support/Compiler.h"
+#include <cstddef>
 
 namespace llvm {
 
@@ -89,6 +90,32 @@ public:
   void emitError(const Instruction *I, const Twine &ErrorStr);
   void emitError(const Twine &ErrorStr);
 
+  /// MemoryUsage - A breakdown of the objects owned by the context.  The byte
+  /// counts are estimates covering the objects themselves and the tables that
+  /// unique them.
+  struct MemoryUsage {
+    size_t NumConstants, ConstantBytes;
+    size_t NumMDNodes, MDNodeBytes;
+    size_t NumMDStrings, MDStringBytes;
+    size_t NumTypes, TypeBytes;
+    size_t NumValueHandles, ValueHandleBytes;
+  };
+
+  /// getMemoryUsage - Fill in Usage with the number of uniqued constants,
+  /// metadata nodes, metadata strings, types and value handles currently
+  /// held by the context, and an estimate of the memory they use.
+  void getMemoryUsage(MemoryUsage &Usage) const;
+
+  /// removeDeadConstantsAndMetadata - Destroy every uniqued constant, metadata
+  /// node and metadata string which has no uses and no value handles pointing
+  /// to it.  This is repeated until nothing else becomes dead.  Types are
+  /// never freed.  Returns the number of objects destroyed.
+  ///
+  /// Clients (analyses in particular) which refer to constants or metadata
+  /// without holding a use or a value handle must not be live when this is
+  /// called, since those references would be left dangling.
+  unsigned removeDeadConstantsAndMetadata();
+
 private:
   LLVMContext(LLVMContext&) LLVM_DELETED_FUNCTION;
   void operator=(LLVMContext&) LLVM_DELETED_FUNCTION;
@@ -33,8 +33,11 @@ struct PassRegistrationListener;
 class PassRegistry {
   mutable void *pImpl;
   void *getImpl() const;
+  bool runNextDeferredInitializer() const;
    
 public:
+  typedef void (*InitializerFn)(PassRegistry &);
+
   PassRegistry() : pImpl(0) { }
   ~PassRegistry();
   
@@ -44,12 +47,24 @@ public:
   static PassRegistry *getPassRegistry();
   
   /// getPassInfo - Look up a pass' corresponding PassInfo, indexed by the pass'
-  /// type identifier (&MyPass::ID).
+  /// type identifier (&MyPass::ID).  Passes register themselves when they
+  /// are constructed, so this does not run deferred initializers.
   const PassInfo *getPassInfo(const void *TI) const;
   
   /// getPassInfo - Look up a pass' corresponding PassInfo, indexed by the pass'
-  /// argument string.
+  /// argument string.  If the pass is not registered, deferred initializers
+  /// are run one at a time until it is.
   const PassInfo *getPassInfo(StringRef Arg) const;
+
+  /// registerDeferredInitializer - Queue an initializer, such as
+  /// initializeScalarOpts, to be run only once a pass is looked up by name,
+  /// the passes are enumerated, or the PassManager needs a required analysis
+  /// nobody has registered.  Tools which build their pipelines directly
+  /// often never run them at all.
+  void registerDeferredInitializer(InitializerFn Init);
+
+  /// runDeferredInitializers - Run every queued initializer now.
+  void runDeferredInitializers();
   
   /// registerPass - Register a pass (by means of its PassInfo) with the 
   /// registry.  Required in order to use the pass with a PassManager.
@@ -68,6 +83,7 @@ public:
   
   /// enumerateWith - Enumerate the registered passes, calling the provided
   /// PassRegistrationListener's passEnumerate() callback on each of them.
+  /// This runs any deferred initializers first.
   void enumerateWith(PassRegistrationListener *L);
   
   /// addRegistrationListener - Register the given PassRegistrationListener
@@ -7,7 +7,8 @@
 //
 //===----------------------------------------------------------------------===//
 //
-// This file defines the MallocAllocator and BumpPtrAllocator interfaces.
+// This file defines the MallocAllocator, BumpPtrAllocator and
+// SizeClassAllocator interfaces.
 //
 //===----------------------------------------------------------------------===//
 
@@ -108,6 +109,10 @@ class BumpPtrAllocator {
   ///
   MemSlab *CurSlab;
 
+  /// FreeSlabs - Slabs kept by Reset(true).  StartNewSlab reuses these before
+  /// asking Allocator for more memory.
+  MemSlab *FreeSlabs;
+
   /// CurPtr - The current pointer into the current slab.  This points to the
   /// next free byte in the slab.
   char *CurPtr;
@@ -120,6 +125,13 @@ class BumpPtrAllocator {
   /// that we can compute how much space was wasted.
   size_t BytesAllocated;
 
+  /// AlignmentWaste - Bytes skipped to align allocations.
+  size_t AlignmentWaste;
+
+  /// SlabTailWaste - Bytes left unused at the end of slabs that were retired
+  /// because the next allocation did not fit.
+  size_t SlabTailWaste;
+
   /// AlignPtr - Align Ptr to Alignment bytes, rounding up.  Alignment should
   /// be a power of two.  This method rounds up, so AlignPtr(7, 4) == 8 and
   /// AlignPtr(8, 4) == 8.
@@ -136,14 +148,18 @@ class BumpPtrAllocator {
   static MallocSlabAllocator DefaultSlabAllocator;
 
   template<typename T> friend class SpecificBumpPtrAllocator;
+  friend class ThreadLocalBumpPtrAllocator;
 public:
   BumpPtrAllocator(size_t size = 4096, size_t threshold = 4096,
                    SlabAllocator &allocator = DefaultSlabAllocator);
   ~BumpPtrAllocator();
 
   /// Reset - Deallocate all but the current slab and reset the current pointer
-  /// to the beginning of it, freeing all memory allocated so far.
-  void Reset();
+  /// to the beginning of it, freeing all memory allocated so far.  If
+  /// KeepSlabs is true, the other slabs are kept for reuse instead of being
+  /// returned to the slab allocator, which avoids going back to malloc when
+  /// the allocator is refilled to a similar size, e.g. once per function.
+  void Reset(bool KeepSlabs = false);
 
   /// Allocate - Allocate space at the specified alignment.
   ///
@@ -174,12 +190,27 @@ public:
 
   void Deallocate(const void * /*Ptr*/) {}
 
+  /// GetNumSlabs - Return the number of slabs in use, not counting the ones
+  /// kept for reuse by Reset(true).
   unsigned GetNumSlabs() const;
 
   void PrintStats() const;
   
-  /// Compute the total physical memory allocated by this allocator.
+  /// Compute the total physical memory allocated by this allocator, including
+  /// slabs kept for reuse.
   size_t getTotalMemory() const;
+
+  /// getBytesAllocated - Return the number of bytes requested from this
+  /// allocator since it was created.
+  size_t getBytesAllocated() const { return BytesAllocated; }
+
+  /// getAlignmentWaste - Return the number of bytes skipped to satisfy
+  /// alignment requests.
+  size_t getAlignmentWaste() const { return AlignmentWaste; }
+
+  /// getSlabTailWaste - Return the number of bytes left unused at the end of
+  /// slabs that were abandoned because an allocation did not fit.
+  size_t getSlabTailWaste() const { return SlabTailWaste; }
 };
 
 /// SpecificBumpPtrAllocator - Same as BumpPtrAllocator but allows only
@@ -221,6 +252,101 @@ public:
   }
 };
 
+/// PrintSizeClassStats - Helper for SizeClassAllocator for printing out
+/// statistics.
+void PrintSizeClassStats(size_t FreeBytes);
+
+/// SizeClassAllocator - A BumpPtrAllocator with a free list per size class,
+/// for clients that free objects of many different sizes and want the memory
+/// reused, like RecyclingAllocator does for a single size.  Requests up to
+/// MaxSize bytes are rounded up to a multiple of Granule and served from the
+/// matching free list when possible.  Larger requests are bump allocated and
+/// never reused.  Deallocate must be passed the size that was allocated.
+template <size_t MaxSize = 256, size_t Granule = 16>
+class SizeClassAllocator {
+  SizeClassAllocator(const SizeClassAllocator &) LLVM_DELETED_FUNCTION;
+  void operator=(const SizeClassAllocator &) LLVM_DELETED_FUNCTION;
+
+  struct FreeNode {
+    FreeNode *Next;
+  };
+
+  enum { NumClasses = MaxSize / Granule };
+
+  BumpPtrAllocator Allocator;
+  FreeNode *FreeLists[NumClasses];
+
+  static unsigned getSizeClass(size_t Size) {
+    return Size ? (Size - 1) / Granule : 0;
+  }
+
+public:
+  SizeClassAllocator(size_t size = 4096, size_t threshold = 4096)
+    : Allocator(size, threshold) {
+    assert(Granule >= sizeof(FreeNode) && isPowerOf2_64(Granule) &&
+           MaxSize % Granule == 0 && "Bad size class layout!");
+    std::fill(FreeLists, FreeLists + NumClasses, (FreeNode*)0);
+  }
+
+  /// Reset - Forget all free lists and reset the underlying BumpPtrAllocator.
+  void Reset(bool KeepSlabs = false) {
+    std::fill(FreeLists, FreeLists + NumClasses, (FreeNode*)0);
+    Allocator.Reset(KeepSlabs);
+  }
+
+  void *Allocate(size_t Size, size_t Alignment) {
+    if (Size > MaxSize)
+      return Allocator.Allocate(Size, Alignment);
+
+    // Blocks on the free lists are only Granule aligned.
+    unsigned Class = getSizeClass(Size);
+    if (Alignment <= Granule && FreeLists[Class]) {
+      FreeNode *Node = FreeLists[Class];
+      FreeLists[Class] = Node->Next;
+      return Node;
+    }
+    return Allocator.Allocate((Class + 1) * Granule,
+                              std::max(Alignment, (size_t)Granule));
+  }
+
+  template <typename T>
+  T *Allocate() {
+    return static_cast<T*>(Allocate(sizeof(T), AlignOf<T>::Alignment));
+  }
+
+  template <typename T>
+  T *Allocate(size_t Num) {
+    return static_cast<T*>(Allocate(Num * sizeof(T), AlignOf<T>::Alignment));
+  }
+
+  /// Deallocate - Make a block of Size bytes returned by Allocate available
+  /// for reuse.
+  void Deallocate(const void *Ptr, size_t Size) {
+    if (Size > MaxSize)
+      return;
+    unsigned Class = getSizeClass(Size);
+    FreeNode *Node = static_cast<FreeNode*>(const_cast<void*>(Ptr));
+    Node->Next = FreeLists[Class];
+    FreeLists[Class] = Node;
+  }
+
+  /// getFreeBytes - Return the number of bytes waiting on the free lists.
+  size_t getFreeBytes() const {
+    size_t Bytes = 0;
+    for (unsigned i = 0; i != NumClasses; ++i)
+      for (FreeNode *N = FreeLists[i]; N; N = N->Next)
+        Bytes += (i + 1) * Granule;
+    return Bytes;
+  }
+
+  BumpPtrAllocator &getAllocator() { return Allocator; }
+
+  void PrintStats() const {
+    Allocator.PrintStats();
+    PrintSizeClassStats(getFreeBytes());
+  }
+};
+
 }  // end namespace llvm
 
 inline void *operator new(size_t Size, llvm::BumpPtrAllocator &Allocator) {
@@ -14,15 +14,15 @@
 #ifndef LLVM_SUPPORT_FILEOUTPUTBUFFER_H
 #define LLVM_SUPPORT_FILEOUTPUTBUFFER_H
 
+#include "llvm/ADT/OwningPtr.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/DataTypes.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/system_error.h"
 
 namespace llvm {
 
-class error_code;
-template<class T> class OwningPtr;
-
 /// FileOutputBuffer - This interface provides simple way to create an in-memory
 /// buffer which will be written to a file. During the lifetime of these 
 /// objects, the content or existence of the specified file is undefined. That
@@ -71,6 +71,11 @@ public:
   /// is used if it turns out you want the file size to be smaller than
   /// initially requested.
   error_code commit(int64_t NewSmallerSize = -1);
+
+  /// Grows the buffer to NewSize bytes, keeping its content.  The buffer may
+  /// be mapped at a different address afterwards.  If this fails the buffer
+  /// is released as if it had not been committed.
+  error_code extend(size_t NewSize);
   
   /// If this object was previously committed, the destructor just deletes
   /// this object.  If this object was not committed, the destructor
@@ -91,6 +96,48 @@ protected:
   SmallString<128>    TempPath;
 };
 
+/// raw_mmap_ostream - A raw_ostream that writes into a FileOutputBuffer.  The
+/// mapped file is the stream's buffer, so output lands in the page cache
+/// without a write(2) for every buffer-full.  The mapping grows as needed and
+/// is trimmed to the bytes written by commit().  As with FileOutputBuffer, the
+/// file only appears if commit() is called.
+class raw_mmap_ostream : public raw_ostream {
+  OwningPtr<FileOutputBuffer> Buffer;
+
+  /// Pos - The number of bytes written to the file, not counting the ones
+  /// still in the stream buffer.
+  size_t Pos;
+
+  /// EC - The first error encountered, if any.
+  error_code EC;
+
+  /// write_impl - See raw_ostream::write_impl.
+  virtual void write_impl(const char *Ptr, size_t Size) LLVM_OVERRIDE;
+
+  /// current_pos - Return the current position within the stream, not
+  /// counting the bytes currently in the buffer.
+  virtual uint64_t current_pos() const LLVM_OVERRIDE { return Pos; }
+
+  /// reserve - Make room for at least Size bytes in the mapping.
+  bool reserve(size_t Size);
+
+public:
+  /// raw_mmap_ostream - Open a mapped output buffer for the file at Path.  On
+  /// failure the error is put into ErrorInfo and all output is discarded.
+  /// SizeHint is the expected size of the output, if known.
+  raw_mmap_ostream(StringRef Path, std::string &ErrorInfo,
+                   size_t SizeHint = 0, unsigned Flags = 0);
+  ~raw_mmap_ostream();
+
+  /// commit - Flush the stream and move the file into place.  Output written
+  /// afterwards is discarded.
+  error_code commit();
+
+  /// has_error - Return true if an error occurred; the file will not be
+  /// written.
+  bool has_error() const { return EC; }
+};
+
 
 
 } // end namespace llvm
@@ -44,6 +44,11 @@ namespace llvm
     ///
     bool DeleteStream;
 
+    /// TookBuffer - Did we take over TheStream's buffering?  If not, we are
+    /// unbuffered and write straight into TheStream's own buffer.
+    ///
+    bool TookBuffer;
+
     /// ColumnScanned - The current output column of the data that's
     /// been flushed and the portion of the buffer that's been
     /// scanned.  The column scheme is zero-based.
@@ -80,14 +85,19 @@ namespace llvm
     /// As a side effect, the given Stream is set to be Unbuffered.
     /// This is because formatted_raw_ostream does its own buffering,
     /// so it doesn't want another layer of buffering to be happening
-    /// underneath it.
+    /// underneath it.  Pass KeepStreamBuffer for streams whose buffer is
+    /// their final destination, such as raw_mmap_ostream; this stream is then
+    /// unbuffered instead and the data is not copied twice.
     ///
-    formatted_raw_ostream(raw_ostream &Stream, bool Delete = false) 
-      : raw_ostream(), TheStream(0), DeleteStream(false), ColumnScanned(0) {
-      setStream(Stream, Delete);
+    formatted_raw_ostream(raw_ostream &Stream, bool Delete = false,
+                          bool KeepStreamBuffer = false)
+      : raw_ostream(), TheStream(0), DeleteStream(false), TookBuffer(false),
+        ColumnScanned(0) {
+      setStream(Stream, Delete, KeepStreamBuffer);
     }
     explicit formatted_raw_ostream()
-      : raw_ostream(), TheStream(0), DeleteStream(false), ColumnScanned(0) {
+      : raw_ostream(), TheStream(0), DeleteStream(false), TookBuffer(false),
+        ColumnScanned(0) {
       Scanned = 0;
     }
 
@@ -96,11 +106,19 @@ namespace llvm
       releaseStream();
     }
 
-    void setStream(raw_ostream &Stream, bool Delete = false) {
+    void setStream(raw_ostream &Stream, bool Delete = false,
+                   bool KeepStreamBuffer = false) {
       releaseStream();
 
       TheStream = &Stream;
       DeleteStream = Delete;
+      TookBuffer = !KeepStreamBuffer;
+      Scanned = 0;
+
+      if (KeepStreamBuffer) {
+        SetUnbuffered();
+        return;
+      }
 
       // This formatted_raw_ostream inherits from raw_ostream, so it'll do its
       // own buffering, and it doesn't need or want TheStream to do another
@@ -111,8 +129,6 @@ namespace llvm
       else
         SetUnbuffered();
       TheStream->SetUnbuffered();
-
-      Scanned = 0;
     }
 
     /// PadToColumn - Align the output to some column number.  If the current
@@ -130,6 +146,8 @@ namespace llvm
         return;
       if (DeleteStream)
         delete TheStream;
+      else if (!TookBuffer)
+        return;
       else if (size_t BufferSize = GetBufferSize())
         TheStream->SetBufferSize(BufferSize);
       else
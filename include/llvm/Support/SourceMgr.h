@@ -122,13 +122,14 @@ public:
   int FindBufferContainingLoc(SMLoc Loc) const;
 
   /// FindLineNumber - Find the line number for the specified location in the
-  /// specified file.  This is not a fast method.
+  /// specified file.  Newlines are indexed as far as the furthest query, so
+  /// each buffer is scanned once and lookups are a binary search.
   unsigned FindLineNumber(SMLoc Loc, int BufferID = -1) const {
     return getLineAndColumn(Loc, BufferID).first;
   }
 
   /// getLineAndColumn - Find the line and column number for the specified
-  /// location in the specified file.  This is not a fast method.
+  /// location in the specified file.  See FindLineNumber.
   std::pair<unsigned, unsigned>
     getLineAndColumn(SMLoc Loc, int BufferID = -1) const;
 
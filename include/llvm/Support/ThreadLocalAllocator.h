@@ -0,0 +1,106 @@
+//===- llvm/Support/ThreadLocalAllocator.h - Per-thread arenas --*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the ThreadLocalBumpPtrAllocator class.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SUPPORT_THREADLOCALALLOCATOR_H
+#define LLVM_SUPPORT_THREADLOCALALLOCATOR_H
+
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/Mutex.h"
+#include "llvm/Support/ThreadLocal.h"
+#include <vector>
+
+namespace llvm {
+
+/// ThreadLocalBumpPtrAllocator - An arena that may be allocated from by
+/// several threads at once.  Each thread bump allocates from its own
+/// BumpPtrAllocator, so the allocation fast path takes no lock; the lock is
+/// only taken the first time a thread allocates from the arena.  Memory stays
+/// valid until the arena is reset or destroyed, even after the thread that
+/// allocated it has exited.
+///
+/// The slab allocator passed in is shared by all threads and must be thread
+/// safe; the default one, which wraps malloc, is.  Reset and the statistics
+/// methods must not run while other threads allocate.  Each arena uses a
+/// thread-local storage key, so arenas are meant to be long lived rather than
+/// created per object.
+class ThreadLocalBumpPtrAllocator {
+  ThreadLocalBumpPtrAllocator(const ThreadLocalBumpPtrAllocator &)
+    LLVM_DELETED_FUNCTION;
+  void operator=(const ThreadLocalBumpPtrAllocator &) LLVM_DELETED_FUNCTION;
+
+  size_t SlabSize;
+  size_t SizeThreshold;
+  SlabAllocator &Allocator;
+
+  /// Current - The allocator owned by the calling thread, if any.
+  /// ThreadLocal only hands out pointers to const.
+  sys::ThreadLocal<const BumpPtrAllocator> Current;
+
+  /// Lock - Guards Allocators.
+  sys::Mutex Lock;
+
+  /// Allocators - Every per-thread allocator created so far.
+  std::vector<BumpPtrAllocator*> Allocators;
+
+  /// createThreadAllocator - Create and register the allocator for the
+  /// calling thread.
+  BumpPtrAllocator &createThreadAllocator();
+
+public:
+  ThreadLocalBumpPtrAllocator(size_t size = 4096, size_t threshold = 4096,
+              SlabAllocator &allocator = BumpPtrAllocator::DefaultSlabAllocator);
+  ~ThreadLocalBumpPtrAllocator();
+
+  /// getThreadAllocator - Return the calling thread's allocator.
+  BumpPtrAllocator &getThreadAllocator() {
+    if (const BumpPtrAllocator *A = Current.get())
+      return *const_cast<BumpPtrAllocator*>(A);
+    return createThreadAllocator();
+  }
+
+  /// Reset - Reset the allocator of every thread.  With KeepSlabs, their slabs
+  /// are kept for reuse; see BumpPtrAllocator::Reset.
+  void Reset(bool KeepSlabs = false);
+
+  void *Allocate(size_t Size, size_t Alignment) {
+    return getThreadAllocator().Allocate(Size, Alignment);
+  }
+
+  template <typename T>
+  T *Allocate() {
+    return static_cast<T*>(Allocate(sizeof(T), AlignOf<T>::Alignment));
+  }
+
+  template <typename T>
+  T *Allocate(size_t Num) {
+    return static_cast<T*>(Allocate(Num * sizeof(T), AlignOf<T>::Alignment));
+  }
+
+  void Deallocate(const void * /*Ptr*/) {}
+
+  /// getNumThreadAllocators - Return the number of threads that have
+  /// allocated from this arena.
+  unsigned getNumThreadAllocators() const { return Allocators.size(); }
+
+  /// Sums of the corresponding BumpPtrAllocator statistics over all threads.
+  size_t getTotalMemory() const;
+  size_t getBytesAllocated() const;
+  size_t getAlignmentWaste() const;
+  size_t getSlabTailWaste() const;
+
+  void PrintStats() const;
+};
+
+}  // end namespace llvm
+
+#endif // LLVM_SUPPORT_THREADLOCALALLOCATOR_H
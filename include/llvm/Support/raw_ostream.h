@@ -260,6 +260,16 @@ private:
   /// \invariant { Size > 0 }
   virtual void write_impl(const char *Ptr, size_t Size) = 0;
 
+  /// writev_impl - Write the \p Size1 bytes starting at \p Ptr1 followed by
+  /// the \p Size2 bytes starting at \p Ptr2.  This is used to write out the
+  /// buffer together with a string too large to be worth copying into it.
+  /// The default calls write_impl for each range; subclasses can override it
+  /// to do both with a single operation.
+  ///
+  /// \invariant { Size1 > 0 && Size2 > 0 }
+  virtual void writev_impl(const char *Ptr1, size_t Size1,
+                           const char *Ptr2, size_t Size2);
+
   // An out of line virtual method to provide a home for the class vtable.
   virtual void handle();
 
@@ -324,6 +334,11 @@ class raw_fd_ostream : public raw_ostream {
   /// write_impl - See raw_ostream::write_impl.
   virtual void write_impl(const char *Ptr, size_t Size) LLVM_OVERRIDE;
 
+  /// writev_impl - See raw_ostream::writev_impl.  This uses writev(2) where
+  /// available.
+  virtual void writev_impl(const char *Ptr1, size_t Size1,
+                           const char *Ptr2, size_t Size2) LLVM_OVERRIDE;
+
   /// current_pos - Return the current position within the stream, not
   /// counting the bytes currently in the buffer.
   virtual uint64_t current_pos() const LLVM_OVERRIDE { return pos; }
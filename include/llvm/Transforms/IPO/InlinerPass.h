@@ -18,9 +18,11 @@
 #define LLVM_TRANSFORMS_IPO_INLINERPASS_H
 
 #include "llvm/CallGraphSCCPass.h"
+#include <vector>
 
 namespace llvm {
   class CallSite;
+  class Function;
   class TargetData;
   class InlineCost;
   template<class PtrType, unsigned SmallSize>
@@ -65,6 +67,21 @@ struct Inliner : public CallGraphSCCPass {
   ///
   virtual InlineCost getInlineCost(CallSite CS) = 0;
 
+  /// resetCachedCostInfo - Erase any cached cost data the derived class holds
+  /// for the specified function. This is called whenever the body of F may
+  /// have changed: when the inliner changes it, before F is deleted, and for
+  /// the functions of an SCC once the passes following the inliner may have
+  /// run on them. If the derived class has no such data this can be left
+  /// empty.
+  ///
+  virtual void resetCachedCostInfo(Function *F) {}
+
+  /// resetCachedCostData - Erase all cached cost data held by the derived
+  /// class. This is called at the end of each run over the module, as other
+  /// passes may change any function before the next run.
+  ///
+  virtual void resetCachedCostData() {}
+
   /// removeDeadFunctions - Remove dead functions.
   ///
   /// This also includes a hack in the form of the 'AlwaysInlineOnly' flag
@@ -80,6 +97,10 @@ private:
   // InsertLifetime - Insert @llvm.lifetime intrinsics.
   bool InsertLifetime;
 
+  // LastSCCFunctions - The functions of the SCC visited last.  The passes
+  // run on that SCC after the inliner may have changed their bodies.
+  std::vector<Function*> LastSCCFunctions;
+
   /// shouldInline - Return true if the inliner should attempt to
   /// inline at the given CallSite.
   bool shouldInline(CallSite CS);
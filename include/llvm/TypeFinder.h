@@ -19,6 +19,7 @@
 
 namespace llvm {
 
+class Function;
 class MDNode;
 class Module;
 class StructType;
@@ -42,6 +43,12 @@ public:
   void run(const Module &M, bool onlyNamed);
   void clear();
 
+  /// incorporateFunction - Add the types used by the signature, arguments and
+  /// body of F.  run() does this for every function in the module; clients
+  /// that read function bodies in lazily can use it after run() to visit the
+  /// bodies one at a time.
+  void incorporateFunction(const Function &F);
+
   typedef std::vector<StructType*>::iterator iterator;
   typedef std::vector<StructType*>::const_iterator const_iterator;
 
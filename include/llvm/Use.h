@@ -142,6 +142,14 @@ private:
     *StrippedPrev = Next;
     if (Next) Next->setPrev(StrippedPrev);
   }
+  /// addRangeToList - Splice the chain of uses from First to Last, which are
+  /// already linked to each other through Next, onto the front of List.
+  static void addRangeToList(Use *First, Use *Last, Use **List) {
+    Last->Next = *List;
+    if (Last->Next) Last->Next->setPrev(&Last->Next);
+    First->setPrev(List);
+    *List = First;
+  }
 
   friend class Value;
 };
@@ -30,10 +30,16 @@
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/Statistic.h"
+#include <algorithm>
 
 using namespace llvm;
 
 STATISTIC(NumCallsAnalyzed, "Number of call sites analyzed");
+STATISTIC(NumCachedCostHits, "Number of call sites costed from the cache");
+
+/// MaxCachedCostsPerCallee - Bound on the number of argument-specialization
+/// buckets we remember for a single callee.
+static const unsigned MaxCachedCostsPerCallee = 16;
 
 namespace {
 
@@ -55,6 +61,9 @@ class CallAnalyzer : public InstVisitor<CallAnalyzer, bool> {
   bool IsRecursiveCall;
   bool ExposesReturnsTwice;
   bool HasDynamicAlloca;
+  /// Whether the cost depends on the body of an indirect call target, which
+  /// the cache key does not cover.
+  bool AnalyzedIndirectCallee;
   /// Number of bytes allocated statically by the callee.
   uint64_t AllocatedSize;
   unsigned NumInstructions, NumVectorInstructions;
@@ -130,7 +139,8 @@ public:
     : TD(TD), F(Callee), Threshold(Threshold), Cost(0),
       AlwaysInline(F.getFnAttributes().hasAlwaysInlineAttr()),
       IsCallerRecursive(false), IsRecursiveCall(false),
-      ExposesReturnsTwice(false), HasDynamicAlloca(false), AllocatedSize(0),
+      ExposesReturnsTwice(false), HasDynamicAlloca(false),
+      AnalyzedIndirectCallee(false), AllocatedSize(0),
       NumInstructions(0), NumVectorInstructions(0),
       FiftyPercentVectorBonus(0), TenPercentVectorBonus(0), VectorBonus(0),
       NumConstantArgs(0), NumConstantOffsetPtrArgs(0), NumAllocaArgs(0),
@@ -139,9 +149,13 @@ public:
   }
 
   bool analyzeCall(CallSite CS);
+  void computeCacheKey(CallSite CS, int Threshold,
+                       SmallVectorImpl<uintptr_t> &Key,
+                       SmallVectorImpl<Constant *> &KeyConstants);
 
   int getThreshold() { return Threshold; }
   int getCost() { return Cost; }
+  bool isCacheable() { return !AnalyzedIndirectCallee; }
 
   // Keep a bunch of stats about the cost savings found so we can print them
   // out when debugging.
@@ -673,6 +687,7 @@ bool CallAnalyzer::visitCallSite(CallSite CS) {
   // during devirtualization and so we want to give it a hefty bonus for
   // inlining, but cap that bonus in the event that inlining wouldn't pan
   // out. Pretend to inline the function, with a custom threshold.
+  AnalyzedIndirectCallee = true;
   CallAnalyzer CA(TD, *F, InlineConstants::IndirectCallThreshold);
   if (CA.analyzeCall(CS)) {
     // We were able to inline the indirect call! Subtract the cost from the
@@ -787,6 +802,91 @@ ConstantInt *CallAnalyzer::stripAndComputeInBoundsConstantOffsets(Value *&V) {
   return cast<ConstantInt>(ConstantInt::get(IntPtrTy, Offset));
 }
 
+/// \brief Test whether the function contains a direct call to itself.
+static bool isRecursiveFunction(Function *F) {
+  for (Value::use_iterator U = F->use_begin(), E = F->use_end();
+       U != E; ++U) {
+    CallSite Site(cast<Value>(*U));
+    if (!Site)
+      continue;
+    Instruction *I = Site.getInstruction();
+    if (I->getParent()->getParent() == F)
+      return true;
+  }
+  return false;
+}
+
+/// \brief Test whether the call site is immediately followed by unreachable,
+/// which makes the callee effectively noreturn at this site.
+static bool isNoReturnCallSite(CallSite CS) {
+  Instruction *Instr = CS.getInstruction();
+  if (InvokeInst *II = dyn_cast<InvokeInst>(Instr))
+    return isa<UnreachableInst>(II->getNormalDest()->begin());
+  return isa<UnreachableInst>(++BasicBlock::iterator(Instr));
+}
+
+/// \brief Compute the argument-specialization bucket for a call site.
+///
+/// Two call sites of this callee with the same key are guaranteed to produce
+/// the same result from analyzeCall. The key captures everything analyzeCall
+/// reads from the call site and the caller: the threshold, the per-call flags,
+/// and for each argument whether it is byval, a constant, or a pointer with a
+/// constant offset from some base. Non-constant bases are numbered in order of
+/// appearance, as only their identity relative to each other (and whether
+/// they are allocas) can influence the simplification of the callee.
+/// The key does not cover the bodies of indirect call targets resolved
+/// through constant arguments; results which depend on one are not cached.
+void CallAnalyzer::computeCacheKey(CallSite CS, int Threshold,
+                                   SmallVectorImpl<uintptr_t> &Key,
+                                   SmallVectorImpl<Constant *> &KeyConstants) {
+  enum {
+    CallerRecursiveFlag = 1 << 0,
+    LastCallToStaticFlag = 1 << 1,
+    NoReturnFlag = 1 << 2
+  };
+  unsigned Flags = 0;
+  Function *Caller = CS.getInstruction()->getParent()->getParent();
+  if (isRecursiveFunction(Caller))
+    Flags |= CallerRecursiveFlag;
+  if (F.hasLocalLinkage() && F.hasOneUse() && &F == CS.getCalledFunction())
+    Flags |= LastCallToStaticFlag;
+  if (isNoReturnCallSite(CS))
+    Flags |= NoReturnFlag;
+
+  Key.push_back(static_cast<uintptr_t>(Threshold));
+  Key.push_back(Flags);
+
+  SmallVector<Value *, 4> Bases;
+  for (unsigned I = 0, E = CS.arg_size(); I != E; ++I) {
+    Value *Arg = CS.getArgument(I);
+    Key.push_back(CS.isByValArgument(I));
+    if (Constant *C = dyn_cast<Constant>(Arg)) {
+      Key.push_back(reinterpret_cast<uintptr_t>(C));
+      Key.push_back(0);
+      KeyConstants.push_back(C);
+      continue;
+    }
+
+    Value *Base = Arg;
+    ConstantInt *Offset = stripAndComputeInBoundsConstantOffsets(Base);
+    if (!Offset) {
+      Key.push_back(0);
+      Key.push_back(0);
+      continue;
+    }
+
+    // Record the base as a (1-based) index into the bases seen so far, tagged
+    // with whether it is an alloca.
+    unsigned BaseIdx = std::find(Bases.begin(), Bases.end(), Base) -
+                       Bases.begin();
+    if (BaseIdx == Bases.size())
+      Bases.push_back(Base);
+    Key.push_back(((BaseIdx + 1) << 1) | isa<AllocaInst>(Base));
+    Key.push_back(reinterpret_cast<uintptr_t>(Offset));
+    KeyConstants.push_back(Offset);
+  }
+}
+
 /// \brief Analyze a call site for potential inlining.
 ///
 /// Returns true if inlining this call is viable, and false if it is not
@@ -852,11 +952,7 @@ bool CallAnalyzer::analyzeCall(CallSite CS) {
     // invoke is an unreachable instruction, the function is noreturn. As such,
     // there is little point in inlining this unless there is literally zero
     // cost.
-    Instruction *Instr = CS.getInstruction();
-    if (InvokeInst *II = dyn_cast<InvokeInst>(Instr)) {
-      if (isa<UnreachableInst>(II->getNormalDest()->begin()))
-        Threshold = 1;
-    } else if (isa<UnreachableInst>(++BasicBlock::iterator(Instr)))
+    if (isNoReturnCallSite(CS))
       Threshold = 1;
 
     // If this function uses the coldcc calling convention, prefer not to inline
@@ -872,19 +968,9 @@ bool CallAnalyzer::analyzeCall(CallSite CS) {
   if (F.empty())
     return true;
 
-  Function *Caller = CS.getInstruction()->getParent()->getParent();
   // Check if the caller function is recursive itself.
-  for (Value::use_iterator U = Caller->use_begin(), E = Caller->use_end();
-       U != E; ++U) {
-    CallSite Site(cast<Value>(*U));
-    if (!Site)
-      continue;
-    Instruction *I = Site.getInstruction();
-    if (I->getParent()->getParent() == Caller) {
-      IsCallerRecursive = true;
-      break;
-    }
-  }
+  IsCallerRecursive =
+    isRecursiveFunction(CS.getInstruction()->getParent()->getParent());
 
   // Track whether we've seen a return instruction. The first return
   // instruction is free, as at least one will usually disappear in inlining.
@@ -1050,15 +1136,38 @@ InlineCost InlineCostAnalyzer::getInlineCost(CallSite CS, Function *Callee,
         << "...\n");
 
   CallAnalyzer CA(TD, *Callee, Threshold);
+
+  // See whether a call site in the same argument-specialization bucket has
+  // already been costed.
+  SmallVector<uintptr_t, 8> Key;
+  SmallVector<Constant *, 4> KeyConstants;
+  CA.computeCacheKey(CS, Threshold, Key, KeyConstants);
+  CachedCostList &Cached = CachedCosts[Callee];
+  for (CachedCostList::iterator I = Cached.begin(), E = Cached.end(); I != E;
+       ++I)
+    if (I->Key.size() == Key.size() &&
+        std::equal(Key.begin(), Key.end(), I->Key.begin()) &&
+        !I->isStale()) {
+      DEBUG(llvm::dbgs() << "      Reusing cached cost\n");
+      ++NumCachedCostHits;
+      return I->Cost;
+    }
+
   bool ShouldInline = CA.analyzeCall(CS);
 
   DEBUG(CA.dump());
 
   // Check if there was a reason to force inlining or no inlining.
-  if (!ShouldInline && CA.getCost() < CA.getThreshold())
-    return InlineCost::getNever();
-  if (ShouldInline && CA.getCost() >= CA.getThreshold())
-    return InlineCost::getAlways();
-
-  return llvm::InlineCost::get(CA.getCost(), CA.getThreshold());
+  InlineCost Result =
+    (!ShouldInline && CA.getCost() < CA.getThreshold()) ?
+      InlineCost::getNever() :
+    (ShouldInline && CA.getCost() >= CA.getThreshold()) ?
+      InlineCost::getAlways() :
+      InlineCost::get(CA.getCost(), CA.getThreshold());
+
+  // Summaries which peeked into an indirect call target also depend on that
+  // function's body, so they cannot be reused safely.
+  if (CA.isCacheable() && Cached.size() < MaxCachedCostsPerCallee)
+    Cached.push_back(CachedCost(Key, KeyConstants, Result));
+  return Result;
 }
@@ -29,6 +29,7 @@
 #include "llvm/ADT/Statistic.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/Support/PredIteratorCache.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Target/TargetData.h"
 using namespace llvm;
@@ -45,11 +46,24 @@ STATISTIC(NumUncacheNonLocalPtr,
           "Number of uncached non-local ptr responses");
 STATISTIC(NumCacheCompleteNonLocalPtr,
           "Number of block queries that were completely cached");
+STATISTIC(NumBlockLimitNonLocalPtr,
+          "Number of non-local ptr queries that hit the block limit");
 
 // Limit for the number of instructions to scan in a block.
 // FIXME: Figure out what a sane value is for this.
 //        (500 is relatively insane.)
-static const int BlockScanLimit = 500;
+static cl::opt<unsigned>
+BlockScanLimit("memdep-block-scan-limit", cl::Hidden, cl::init(500),
+  cl::desc("The number of instructions to scan in a block in memory "
+           "dependency analysis (default = 500)"));
+
+// Limit for the number of blocks a single non-local pointer query may visit.
+// Queries which would walk further are answered conservatively, which bounds
+// both the time spent in them and the size of the caches they populate.
+static cl::opt<unsigned>
+BlockNumberLimit("memdep-block-number-limit", cl::Hidden, cl::init(1000),
+  cl::desc("The number of blocks to scan during a non-local memory "
+           "dependency query (default = 1000)"));
 
 char MemoryDependenceAnalysis::ID = 0;
   
@@ -1015,7 +1029,17 @@ getNonLocalPointerDepFromBB(const PHITransAddr &Pointer,
   
   while (!Worklist.empty()) {
     BasicBlock *BB = Worklist.pop_back_val();
-    
+
+    // If the query has already visited too many blocks, give up and treat the
+    // pointer as clobbered.  The per-block entries added to the cache so far
+    // are still accurate, but it no longer holds the complete result.
+    if (Visited.size() > BlockNumberLimit) {
+      SortNonLocalDepInfoCache(*Cache, NumSortedEntries);
+      CacheInfo->Pair = BBSkipFirstBlockPair();
+      ++NumBlockLimitNonLocalPtr;
+      return true;
+    }
+
     // Skip the first block if we have it.
     if (!SkipFirstBlock) {
       // Analyze the dependency of *Pointer in FromBB.  See if we already have
@@ -97,6 +97,10 @@ STATISTIC(NumTripCountsNotComputed,
           "Number of loops without predictable loop counts");
 STATISTIC(NumBruteForceTripCountsComputed,
           "Number of loops with trip counts computed by force");
+STATISTIC(NumScopeCacheHits,
+          "Number of getSCEVAtScope queries answered from the cache");
+STATISTIC(NumScopeCacheMisses,
+          "Number of getSCEVAtScope queries which had to be computed");
 
 static cl::opt<unsigned>
 MaxBruteForceIterations("scalar-evolution-max-iterations", cl::ReallyHidden,
@@ -4135,12 +4139,44 @@ void ScalarEvolution::forgetLoop(const Loop *L) {
     PushDefUseChildren(I, Worklist);
   }
 
+  forgetScopeEntries(L);
+
   // Forget all contained loops too, to avoid dangling entries in the
   // ValuesAtScopes map.
   for (Loop::iterator I = L->begin(), E = L->end(); I != E; ++I)
     forgetLoop(*I);
 }
 
+/// eraseScopeEntry - Remove the entry for scope L from the per-expression
+/// vector for S in Map, and the vector itself once it is empty.
+template <typename MapTy>
+static void eraseScopeEntry(MapTy &Map, const SCEV *S, const Loop *L) {
+  typename MapTy::iterator I = Map.find(S);
+  if (I == Map.end())
+    return;
+  for (unsigned u = I->second.size(); u > 0; u--)
+    if (I->second[u - 1].first == L) {
+      I->second.erase(I->second.begin() + u - 1);
+      break;
+    }
+  if (I->second.empty())
+    Map.erase(I);
+}
+
+void ScalarEvolution::forgetScopeEntries(const Loop *L) {
+  DenseMap<const Loop *, SmallPtrSet<const SCEV *, 8> >::iterator I =
+    ScopeUsers.find(L);
+  if (I == ScopeUsers.end())
+    return;
+  // Entries already dropped by forgetMemoizedResults are simply not found.
+  for (SmallPtrSet<const SCEV *, 8>::iterator SI = I->second.begin(),
+       SE = I->second.end(); SI != SE; ++SI) {
+    eraseScopeEntry(ValuesAtScopes, *SI, L);
+    eraseScopeEntry(LoopDispositions, *SI, L);
+  }
+  ScopeUsers.erase(I);
+}
+
 /// forgetValue - This method should be called by the client when it has
 /// changed a value in a way that may effect its value, or which may
 /// disconnect it from a def-use chain linking it to a loop.
@@ -4980,15 +5016,28 @@ const SCEV *ScalarEvolution::ComputeExitCountExhaustively(const Loop *L,
 /// original value V is returned.
 const SCEV *ScalarEvolution::getSCEVAtScope(const SCEV *V, const Loop *L) {
   // Check to see if we've folded this expression at this loop before.
-  std::map<const Loop *, const SCEV *> &Values = ValuesAtScopes[V];
-  std::pair<std::map<const Loop *, const SCEV *>::iterator, bool> Pair =
-    Values.insert(std::make_pair(L, static_cast<const SCEV *>(0)));
-  if (!Pair.second)
-    return Pair.first->second ? Pair.first->second : V;
+  SmallVector<std::pair<const Loop *, const SCEV *>, 2> &Values =
+    ValuesAtScopes[V];
+  for (unsigned u = 0, e = Values.size(); u != e; ++u)
+    if (Values[u].first == L) {
+      ++NumScopeCacheHits;
+      return Values[u].second ? Values[u].second : V;
+    }
+  Values.push_back(std::make_pair(L, static_cast<const SCEV *>(0)));
+  if (L)
+    ScopeUsers[L].insert(V);
 
-  // Otherwise compute it.
+  // Otherwise compute it.  This may recursively insert into ValuesAtScopes,
+  // so look the entry up again before updating it.
+  ++NumScopeCacheMisses;
   const SCEV *C = computeSCEVAtScope(V, L);
-  ValuesAtScopes[V][L] = C;
+  SmallVector<std::pair<const Loop *, const SCEV *>, 2> &Values2 =
+    ValuesAtScopes[V];
+  for (unsigned u = Values2.size(); u > 0; u--)
+    if (Values2[u - 1].first == L) {
+      Values2[u - 1].second = C;
+      break;
+    }
   return C;
 }
 
@@ -6619,6 +6668,7 @@ void ScalarEvolution::releaseMemory() {
   ConstantEvolutionLoopExitValue.clear();
   ValuesAtScopes.clear();
   LoopDispositions.clear();
+  ScopeUsers.clear();
   BlockDispositions.clear();
   UnsignedRanges.clear();
   SignedRanges.clear();
@@ -6721,14 +6771,24 @@ void ScalarEvolution::print(raw_ostream &OS, const Module *) const {
 
 ScalarEvolution::LoopDisposition
 ScalarEvolution::getLoopDisposition(const SCEV *S, const Loop *L) {
-  std::map<const Loop *, LoopDisposition> &Values = LoopDispositions[S];
-  std::pair<std::map<const Loop *, LoopDisposition>::iterator, bool> Pair =
-    Values.insert(std::make_pair(L, LoopVariant));
-  if (!Pair.second)
-    return Pair.first->second;
+  SmallVector<std::pair<const Loop *, LoopDisposition>, 2> &Values =
+    LoopDispositions[S];
+  for (unsigned u = 0, e = Values.size(); u != e; ++u)
+    if (Values[u].first == L)
+      return Values[u].second;
+  Values.push_back(std::make_pair(L, LoopVariant));
+  if (L)
+    ScopeUsers[L].insert(S);
 
   LoopDisposition D = computeLoopDisposition(S, L);
-  return LoopDispositions[S][L] = D;
+  SmallVector<std::pair<const Loop *, LoopDisposition>, 2> &Values2 =
+    LoopDispositions[S];
+  for (unsigned u = Values2.size(); u > 0; u--)
+    if (Values2[u - 1].first == L) {
+      Values2[u - 1].second = D;
+      break;
+    }
+  return D;
 }
 
 ScalarEvolution::LoopDisposition
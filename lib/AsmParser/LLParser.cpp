@@ -33,6 +33,19 @@ static std::string getTypeString(Type *T) {
   return Tmp.str();
 }
 
+/// getFirstForwardRef - Return the entry of a forward reference table whose
+/// reference appears first in the source.  The tables are hashed, so this
+/// keeps the "use of undefined value" diagnostic independent of their order.
+template<typename MapTy>
+static typename MapTy::const_iterator getFirstForwardRef(const MapTy &Map) {
+  typename MapTy::const_iterator First = Map.begin();
+  for (typename MapTy::const_iterator I = Map.begin(), E = Map.end();
+       I != E; ++I)
+    if (I->second.second.getPointer() < First->second.second.getPointer())
+      First = I;
+  return First;
+}
+
 /// Run: module ::= toplevelentity*
 bool LLParser::Run() {
   // Prime the lexer.
@@ -121,15 +134,19 @@ bool LLParser::ValidateEndOfModule() {
       return Error(I->second.second,
                    "use of undefined type named '" + I->getKey() + "'");
 
-  if (!ForwardRefVals.empty())
-    return Error(ForwardRefVals.begin()->second.second,
-                 "use of undefined value '@" + ForwardRefVals.begin()->first +
-                 "'");
+  if (!ForwardRefVals.empty()) {
+    StringMap<std::pair<GlobalValue*, LocTy> >::const_iterator
+      I = getFirstForwardRef(ForwardRefVals);
+    return Error(I->second.second,
+                 "use of undefined value '@" + I->getKey() + "'");
+  }
 
-  if (!ForwardRefValIDs.empty())
-    return Error(ForwardRefValIDs.begin()->second.second,
-                 "use of undefined value '@" +
-                 Twine(ForwardRefValIDs.begin()->first) + "'");
+  if (!ForwardRefValIDs.empty()) {
+    DenseMap<unsigned, std::pair<GlobalValue*, LocTy> >::const_iterator
+      I = getFirstForwardRef(ForwardRefValIDs);
+    return Error(I->second.second,
+                 "use of undefined value '@" + Twine(I->first) + "'");
+  }
 
   if (!ForwardRefMDNodes.empty())
     return Error(ForwardRefMDNodes.begin()->second.second,
@@ -629,7 +646,7 @@ bool LLParser::ParseAlias(const std::string &Name, LocTy NameLoc,
   if (GlobalValue *Val = M->getNamedValue(Name)) {
     // See if this was a redefinition.  If so, there is no entry in
     // ForwardRefVals.
-    std::map<std::string, std::pair<GlobalValue*, LocTy> >::iterator
+    StringMap<std::pair<GlobalValue*, LocTy> >::iterator
       I = ForwardRefVals.find(Name);
     if (I == ForwardRefVals.end())
       return Error(NameLoc, "redefinition of global named '@" + Name + "'");
@@ -703,7 +720,7 @@ bool LLParser::ParseGlobal(const std::string &Name, LocTy NameLoc,
       GV = cast<GlobalVariable>(GVal);
     }
   } else {
-    std::map<unsigned, std::pair<GlobalValue*, LocTy> >::iterator
+    DenseMap<unsigned, std::pair<GlobalValue*, LocTy> >::iterator
       I = ForwardRefValIDs.find(NumberedVals.size());
     if (I != ForwardRefValIDs.end()) {
       GV = cast<GlobalVariable>(I->second.first);
@@ -780,7 +797,7 @@ GlobalValue *LLParser::GetGlobalVal(const std::string &Name, Type *Ty,
   // If this is a forward reference for the value, see if we already created a
   // forward ref record.
   if (Val == 0) {
-    std::map<std::string, std::pair<GlobalValue*, LocTy> >::iterator
+    StringMap<std::pair<GlobalValue*, LocTy> >::iterator
       I = ForwardRefVals.find(Name);
     if (I != ForwardRefVals.end())
       Val = I->second.first;
@@ -813,12 +830,19 @@ GlobalValue *LLParser::GetGlobalVal(unsigned ID, Type *Ty, LocTy Loc) {
     return 0;
   }
 
+  // The forward reference table reserves the two largest IDs, and no module
+  // can number that many values anyway.
+  if (ID >= ~0U - 1) {
+    Error(Loc, "invalid value number (too large)!");
+    return 0;
+  }
+
   GlobalValue *Val = ID < NumberedVals.size() ? NumberedVals[ID] : 0;
 
   // If this is a forward reference for the value, see if we already created a
   // forward ref record.
   if (Val == 0) {
-    std::map<unsigned, std::pair<GlobalValue*, LocTy> >::iterator
+    DenseMap<unsigned, std::pair<GlobalValue*, LocTy> >::iterator
       I = ForwardRefValIDs.find(ID);
     if (I != ForwardRefValIDs.end())
       Val = I->second.first;
@@ -1804,7 +1828,7 @@ LLParser::PerFunctionState::PerFunctionState(LLParser &p, Function &f,
 
 LLParser::PerFunctionState::~PerFunctionState() {
   // If there were any forward referenced non-basicblock values, delete them.
-  for (std::map<std::string, std::pair<Value*, LocTy> >::iterator
+  for (StringMap<std::pair<Value*, LocTy> >::iterator
        I = ForwardRefVals.begin(), E = ForwardRefVals.end(); I != E; ++I)
     if (!isa<BasicBlock>(I->second.first)) {
       I->second.first->replaceAllUsesWith(
@@ -1813,7 +1837,7 @@ LLParser::PerFunctionState::~PerFunctionState() {
       I->second.first = 0;
     }
 
-  for (std::map<unsigned, std::pair<Value*, LocTy> >::iterator
+  for (DenseMap<unsigned, std::pair<Value*, LocTy> >::iterator
        I = ForwardRefValIDs.begin(), E = ForwardRefValIDs.end(); I != E; ++I)
     if (!isa<BasicBlock>(I->second.first)) {
       I->second.first->replaceAllUsesWith(
@@ -1846,14 +1870,18 @@ bool LLParser::PerFunctionState::FinishFunction() {
     }
   }
   
-  if (!ForwardRefVals.empty())
-    return P.Error(ForwardRefVals.begin()->second.second,
-                   "use of undefined value '%" + ForwardRefVals.begin()->first +
-                   "'");
-  if (!ForwardRefValIDs.empty())
-    return P.Error(ForwardRefValIDs.begin()->second.second,
-                   "use of undefined value '%" +
-                   Twine(ForwardRefValIDs.begin()->first) + "'");
+  if (!ForwardRefVals.empty()) {
+    StringMap<std::pair<Value*, LocTy> >::const_iterator
+      I = getFirstForwardRef(ForwardRefVals);
+    return P.Error(I->second.second,
+                   "use of undefined value '%" + I->getKey() + "'");
+  }
+  if (!ForwardRefValIDs.empty()) {
+    DenseMap<unsigned, std::pair<Value*, LocTy> >::const_iterator
+      I = getFirstForwardRef(ForwardRefValIDs);
+    return P.Error(I->second.second,
+                   "use of undefined value '%" + Twine(I->first) + "'");
+  }
   return false;
 }
 
@@ -1869,7 +1897,7 @@ Value *LLParser::PerFunctionState::GetVal(const std::string &Name,
   // If this is a forward reference for the value, see if we already created a
   // forward ref record.
   if (Val == 0) {
-    std::map<std::string, std::pair<Value*, LocTy> >::iterator
+    StringMap<std::pair<Value*, LocTy> >::iterator
       I = ForwardRefVals.find(Name);
     if (I != ForwardRefVals.end())
       Val = I->second.first;
@@ -1905,13 +1933,20 @@ Value *LLParser::PerFunctionState::GetVal(const std::string &Name,
 
 Value *LLParser::PerFunctionState::GetVal(unsigned ID, Type *Ty,
                                           LocTy Loc) {
+  // The forward reference table reserves the two largest IDs, and no function
+  // can number that many values anyway.
+  if (ID >= ~0U - 1) {
+    P.Error(Loc, "invalid value number (too large)!");
+    return 0;
+  }
+
   // Look this name up in the normal function symbol table.
   Value *Val = ID < NumberedVals.size() ? NumberedVals[ID] : 0;
 
   // If this is a forward reference for the value, see if we already created a
   // forward ref record.
   if (Val == 0) {
-    std::map<unsigned, std::pair<Value*, LocTy> >::iterator
+    DenseMap<unsigned, std::pair<Value*, LocTy> >::iterator
       I = ForwardRefValIDs.find(ID);
     if (I != ForwardRefValIDs.end())
       Val = I->second.first;
@@ -1967,7 +2002,7 @@ bool LLParser::PerFunctionState::SetInstName(int NameID,
       return P.Error(NameLoc, "instruction expected to be numbered '%" +
                      Twine(NumberedVals.size()) + "'");
 
-    std::map<unsigned, std::pair<Value*, LocTy> >::iterator FI =
+    DenseMap<unsigned, std::pair<Value*, LocTy> >::iterator FI =
       ForwardRefValIDs.find(NameID);
     if (FI != ForwardRefValIDs.end()) {
       if (FI->second.first->getType() != Inst->getType())
@@ -1983,7 +2018,7 @@ bool LLParser::PerFunctionState::SetInstName(int NameID,
   }
 
   // Otherwise, the instruction had a name.  Resolve forward refs and set it.
-  std::map<std::string, std::pair<Value*, LocTy> >::iterator
+  StringMap<std::pair<Value*, LocTy> >::iterator
     FI = ForwardRefVals.find(NameStr);
   if (FI != ForwardRefVals.end()) {
     if (FI->second.first->getType() != Inst->getType())
@@ -2883,7 +2918,7 @@ bool LLParser::ParseFunctionHeader(Function *&Fn, bool isDefine) {
   if (!FunctionName.empty()) {
     // If this was a definition of a forward reference, remove the definition
     // from the forward reference table and fill in the forward ref.
-    std::map<std::string, std::pair<GlobalValue*, LocTy> >::iterator FRVI =
+    StringMap<std::pair<GlobalValue*, LocTy> >::iterator FRVI =
       ForwardRefVals.find(FunctionName);
     if (FRVI != ForwardRefVals.end()) {
       Fn = M->getFunction(FunctionName);
@@ -2903,7 +2938,7 @@ bool LLParser::ParseFunctionHeader(Function *&Fn, bool isDefine) {
   } else {
     // If this is a definition of a forward referenced function, make sure the
     // types agree.
-    std::map<unsigned, std::pair<GlobalValue*, LocTy> >::iterator I
+    DenseMap<unsigned, std::pair<GlobalValue*, LocTy> >::iterator I
       = ForwardRefValIDs.find(NumberedVals.size());
     if (I != ForwardRefValIDs.end()) {
       Fn = cast<Function>(I->second.first);
@@ -116,8 +116,8 @@ namespace llvm {
     std::map<unsigned, std::pair<TrackingVH<MDNode>, LocTy> > ForwardRefMDNodes;
 
     // Global Value reference information.
-    std::map<std::string, std::pair<GlobalValue*, LocTy> > ForwardRefVals;
-    std::map<unsigned, std::pair<GlobalValue*, LocTy> > ForwardRefValIDs;
+    StringMap<std::pair<GlobalValue*, LocTy> > ForwardRefVals;
+    DenseMap<unsigned, std::pair<GlobalValue*, LocTy> > ForwardRefValIDs;
     std::vector<GlobalValue*> NumberedVals;
     
     // References to blockaddress.  The key is the function ValID, the value is
@@ -239,8 +239,8 @@ namespace llvm {
     class PerFunctionState {
       LLParser &P;
       Function &F;
-      std::map<std::string, std::pair<Value*, LocTy> > ForwardRefVals;
-      std::map<unsigned, std::pair<Value*, LocTy> > ForwardRefValIDs;
+      StringMap<std::pair<Value*, LocTy> > ForwardRefVals;
+      DenseMap<unsigned, std::pair<Value*, LocTy> > ForwardRefValIDs;
       std::vector<Value*> NumberedVals;
       
       /// FunctionNumber - If this is an unnamed function, this is the slot
@@ -46,6 +46,9 @@ void BitcodeReader::FreeState() {
   std::vector<Type*>().swap(TypeList);
   ValueList.clear();
   MDValueList.clear();
+  std::vector<uint64_t>().swap(LazyMDOffsets);
+  PendingLazyMDs.clear();
+  LazyMDCursor.freeState();
 
   std::vector<AttrListPtr>().swap(MAttributes);
   std::vector<BasicBlock*>().swap(FunctionBBs);
@@ -790,9 +793,13 @@ bool BitcodeReader::ParseValueSymbolTable() {
   }
 }
 
-bool BitcodeReader::ParseMetadata() {
+bool BitcodeReader::ParseMetadata(bool AllowDeferral) {
   unsigned NextMDValueNo = MDValueList.size();
 
+  // Only one block can be deferred, since LazyMDCursor holds the
+  // abbreviations of a single block.
+  bool Defer = AllowDeferral && LazyMetadata && LazyMDOffsets.empty();
+
   if (Stream.EnterSubBlock(bitc::METADATA_BLOCK_ID))
     return Error("Malformed block record");
 
@@ -800,11 +807,14 @@ bool BitcodeReader::ParseMetadata() {
 
   // Read all the records.
   while (1) {
+    uint64_t RecordBit = Stream.GetCurrentBitNo();
     unsigned Code = Stream.ReadCode();
     if (Code == bitc::END_BLOCK) {
+      if (Defer && !LazyMDOffsets.empty())
+        LazyMDCursor = Stream;
       if (Stream.ReadBlockEnd())
         return Error("Error at end of PARAMATTR block");
-      return false;
+      break;
     }
 
     if (Code == bitc::ENTER_SUBBLOCK) {
@@ -820,7 +830,6 @@ bool BitcodeReader::ParseMetadata() {
       continue;
     }
 
-    bool IsFunctionLocal = false;
     // Read a record.
     Record.clear();
     Code = Stream.ReadRecord(Code, Record);
@@ -841,7 +850,7 @@ bool BitcodeReader::ParseMetadata() {
       unsigned Size = Record.size();
       NamedMDNode *NMD = TheModule->getOrInsertNamedMetadata(Name);
       for (unsigned i = 0; i != Size; ++i) {
-        MDNode *MD = dyn_cast<MDNode>(MDValueList.getValueFwdRef(Record[i]));
+        MDNode *MD = dyn_cast<MDNode>(getMDValueFwdRef(Record[i]));
         if (MD == 0)
           return Error("Malformed metadata record");
         NMD->addOperand(MD);
@@ -849,35 +858,18 @@ bool BitcodeReader::ParseMetadata() {
       break;
     }
     case bitc::METADATA_FN_NODE:
-      IsFunctionLocal = true;
-      // fall-through
-    case bitc::METADATA_NODE: {
-      if (Record.size() % 2 == 1)
-        return Error("Invalid METADATA_NODE record");
-
-      unsigned Size = Record.size();
-      SmallVector<Value*, 8> Elts;
-      for (unsigned i = 0; i != Size; i += 2) {
-        Type *Ty = getTypeByID(Record[i]);
-        if (!Ty) return Error("Invalid METADATA_NODE record");
-        if (Ty->isMetadataTy())
-          Elts.push_back(MDValueList.getValueFwdRef(Record[i+1]));
-        else if (!Ty->isVoidTy())
-          Elts.push_back(ValueList.getValueFwdRef(Record[i+1], Ty));
-        else
-          Elts.push_back(NULL);
+    case bitc::METADATA_NODE:
+    case bitc::METADATA_STRING:
+      if (Defer) {
+        // Just remember where the value is defined.
+        if (NextMDValueNo >= LazyMDOffsets.size())
+          LazyMDOffsets.resize(NextMDValueNo+1);
+        LazyMDOffsets[NextMDValueNo++] = RecordBit;
+        break;
       }
-      Value *V = MDNode::getWhenValsUnresolved(Context, Elts, IsFunctionLocal);
-      IsFunctionLocal = false;
-      MDValueList.AssignValue(V, NextMDValueNo++);
-      break;
-    }
-    case bitc::METADATA_STRING: {
-      SmallString<8> String(Record.begin(), Record.end());
-      Value *V = MDString::get(Context, String);
-      MDValueList.AssignValue(V, NextMDValueNo++);
+      if (ParseMetadataValue(Code, Record, NextMDValueNo++))
+        return true;
       break;
-    }
     case bitc::METADATA_KIND: {
       if (Record.size() < 2)
         return Error("Invalid METADATA_KIND record");
@@ -892,6 +884,127 @@ bool BitcodeReader::ParseMetadata() {
     }
     }
   }
+
+  if (!Defer || LazyMDOffsets.empty())
+    return false;
+
+  // Function-local metadata is numbered after the deferred values.  Anything
+  // referenced so far (by named metadata or type attachments) is built now.
+  if (MDValueList.size() < LazyMDOffsets.size())
+    MDValueList.resize(LazyMDOffsets.size());
+  for (unsigned ID = 0, e = LazyMDOffsets.size(); ID != e; ++ID)
+    if (LazyMDOffsets[ID] && MDValueList[ID])
+      PendingLazyMDs.push_back(ID);
+  return materializePendingMetadata();
+}
+
+/// ParseMetadataValue - Build the node or string defined by a METADATA_NODE,
+/// METADATA_FN_NODE or METADATA_STRING record, and assign it metadata ID ID.
+bool BitcodeReader::ParseMetadataValue(unsigned Code,
+                                       SmallVector<uint64_t, 64> &Record,
+                                       unsigned ID) {
+  switch (Code) {
+  default:
+    return Error("Invalid metadata record");
+  case bitc::METADATA_FN_NODE:
+  case bitc::METADATA_NODE: {
+    if (Record.size() % 2 == 1)
+      return Error("Invalid METADATA_NODE record");
+
+    unsigned Size = Record.size();
+    SmallVector<Value*, 8> Elts;
+    for (unsigned i = 0; i != Size; i += 2) {
+      Type *Ty = getTypeByID(Record[i]);
+      if (!Ty) return Error("Invalid METADATA_NODE record");
+      if (Ty->isMetadataTy())
+        Elts.push_back(getMDValueFwdRef(Record[i+1]));
+      else if (!Ty->isVoidTy())
+        Elts.push_back(ValueList.getValueFwdRef(Record[i+1], Ty));
+      else
+        Elts.push_back(NULL);
+    }
+    bool IsFunctionLocal = Code == bitc::METADATA_FN_NODE;
+    Value *V = MDNode::getWhenValsUnresolved(Context, Elts, IsFunctionLocal);
+    MDValueList.AssignValue(V, ID);
+    return false;
+  }
+  case bitc::METADATA_STRING: {
+    SmallString<8> String(Record.begin(), Record.end());
+    Value *V = MDString::get(Context, String);
+    MDValueList.AssignValue(V, ID);
+    return false;
+  }
+  }
+}
+
+/// getMDValueFwdRef - Return the metadata value with the specified ID, or a
+/// temporary node standing in for it.  If the value is deferred it is queued
+/// for the next call to materializePendingMetadata.
+Value *BitcodeReader::getMDValueFwdRef(unsigned ID) {
+  if (ID < LazyMDOffsets.size() && LazyMDOffsets[ID])
+    PendingLazyMDs.push_back(ID);
+  return MDValueList.getValueFwdRef(ID);
+}
+
+/// getMDValue - Like getMDValueFwdRef, but build a deferred value right away
+/// rather than returning a temporary node.  Returns null on error.
+Value *BitcodeReader::getMDValue(unsigned ID) {
+  getMDValueFwdRef(ID);
+  if (materializePendingMetadata())
+    return 0;
+  return MDValueList[ID];
+}
+
+/// materializePendingMetadata - Build every queued deferred metadata value,
+/// along with the deferred values it refers to.  The whole set is collected
+/// first and then built in ID order, which is the order the writer emitted
+/// the records in, so operands are mostly built before their users.
+bool BitcodeReader::materializePendingMetadata() {
+  if (PendingLazyMDs.empty())
+    return false;
+
+  SmallVector<uint64_t, 64> Record;
+  std::vector<std::pair<unsigned, uint64_t> > Deferred;
+  while (!PendingLazyMDs.empty()) {
+    unsigned ID = PendingLazyMDs.pop_back_val();
+    uint64_t Bit = LazyMDOffsets[ID];
+    if (!Bit)
+      continue;
+    LazyMDOffsets[ID] = 0;
+    Deferred.push_back(std::make_pair(ID, Bit));
+
+    LazyMDCursor.JumpToBit(Bit);
+    Record.clear();
+    unsigned Code = LazyMDCursor.ReadRecord(LazyMDCursor.ReadCode(), Record);
+    if (Code != bitc::METADATA_NODE && Code != bitc::METADATA_FN_NODE)
+      continue;
+    for (unsigned i = 0, e = Record.size(); i + 1 < e; i += 2) {
+      Type *Ty = getTypeByID(Record[i]);
+      unsigned OpID = Record[i+1];
+      if (Ty && Ty->isMetadataTy() && OpID < LazyMDOffsets.size() &&
+          LazyMDOffsets[OpID])
+        PendingLazyMDs.push_back(OpID);
+    }
+  }
+
+  std::sort(Deferred.begin(), Deferred.end());
+  for (unsigned i = 0, e = Deferred.size(); i != e; ++i) {
+    LazyMDCursor.JumpToBit(Deferred[i].second);
+    Record.clear();
+    unsigned Code = LazyMDCursor.ReadRecord(LazyMDCursor.ReadCode(), Record);
+    if (ParseMetadataValue(Code, Record, Deferred[i].first))
+      return true;
+  }
+  return false;
+}
+
+/// materializeAllMetadata - Build every metadata value which is still
+/// deferred.
+bool BitcodeReader::materializeAllMetadata() {
+  for (unsigned ID = 0, e = LazyMDOffsets.size(); ID != e; ++ID)
+    if (LazyMDOffsets[ID])
+      PendingLazyMDs.push_back(ID);
+  return materializePendingMetadata();
 }
 
 /// DecodeSignRotatedValue - Decode a signed value stored with the sign bit in
@@ -1485,7 +1598,7 @@ bool BitcodeReader::ParseModule(bool Resume) {
           return true;
         break;
       case bitc::METADATA_BLOCK_ID:
-        if (ParseMetadata())
+        if (ParseMetadata(/*AllowDeferral=*/true))
           return true;
         break;
       case bitc::FUNCTION_BLOCK_ID:
@@ -1892,7 +2005,7 @@ bool BitcodeReader::ParseMetadataAttachment() {
           MDKindMap.find(Kind);
         if (I == MDKindMap.end())
           return Error("Invalid metadata kind ID");
-        Value *Node = MDValueList.getValueFwdRef(Record[i+1]);
+        Value *Node = getMDValueFwdRef(Record[i+1]);
         Inst->setMetadata(I->second, cast<MDNode>(Node));
       }
       break;
@@ -1935,7 +2048,7 @@ bool BitcodeReader::ParseTypeMetadataAttachment() {
           MDKindMap.find(Kind);
         if (I == MDKindMap.end())
           return Error("Invalid metadata kind ID");
-        Value *Node = MDValueList.getValueFwdRef(Record[i+1]);
+        Value *Node = getMDValueFwdRef(Record[i+1]);
         Ty->setMetadata(I->second, cast<MDNode>(Node));
       }
       break;
@@ -2049,9 +2162,19 @@ bool BitcodeReader::ParseFunctionBody(Function *F) {
       unsigned Line = Record[0], Col = Record[1];
       unsigned ScopeID = Record[2], IAID = Record[3];
       
+      // Build deferred scopes now so the location does not refer to a
+      // temporary node.
       MDNode *Scope = 0, *IA = 0;
-      if (ScopeID) Scope = cast<MDNode>(MDValueList.getValueFwdRef(ScopeID-1));
-      if (IAID)    IA = cast<MDNode>(MDValueList.getValueFwdRef(IAID-1));
+      if (ScopeID) {
+        Value *V = getMDValue(ScopeID-1);
+        if (!V) return true;
+        Scope = cast<MDNode>(V);
+      }
+      if (IAID) {
+        Value *V = getMDValue(IAID-1);
+        if (!V) return true;
+        IA = cast<MDNode>(V);
+      }
       LastLoc = DebugLoc::get(Line, Col, Scope, IA);
       I->setDebugLoc(LastLoc);
       I = 0;
@@ -2771,6 +2894,10 @@ bool BitcodeReader::ParseFunctionBody(Function *F) {
     }
   }
 
+  // Build any deferred metadata the function refers to.
+  if (materializePendingMetadata())
+    return true;
+
   // FIXME: Check for unresolved forward-declared metadata references
   // and clean up leaks.
 
@@ -2884,6 +3011,12 @@ void BitcodeReader::Dematerialize(GlobalValue *GV) {
 bool BitcodeReader::MaterializeModule(Module *M, std::string *ErrInfo) {
   assert(M == TheModule &&
          "Can only Materialize the Module this BitcodeReader is attached to.");
+  // Build all deferred metadata first, so function bodies find it in place.
+  if (materializeAllMetadata()) {
+    if (ErrInfo) *ErrInfo = ErrorString;
+    return true;
+  }
+
   // Iterate over the module, deserializing any functions that are still on
   // disk.
   for (Module::iterator F = TheModule->begin(), E = TheModule->end();
@@ -2976,14 +3109,17 @@ bool BitcodeReader::InitLazyStream() {
 // External interface
 //===----------------------------------------------------------------------===//
 
-/// getLazyBitcodeModule - lazy function-at-a-time loading from a file.
-///
-Module *llvm::getLazyBitcodeModule(MemoryBuffer *Buffer,
-                                   LLVMContext& Context,
-                                   std::string *ErrMsg) {
+/// getLazyBitcodeModuleImpl - Read the module header from the specified
+/// buffer, leaving function bodies (and, if LazyMetadata is set, module-level
+/// metadata) to be read on demand.
+static Module *getLazyBitcodeModuleImpl(MemoryBuffer *Buffer,
+                                        LLVMContext &Context,
+                                        std::string *ErrMsg,
+                                        bool LazyMetadata) {
   Module *M = new Module(Buffer->getBufferIdentifier(), Context);
   BitcodeReader *R = new BitcodeReader(Buffer, Context);
   M->setMaterializer(R);
+  R->setLazyMetadata(LazyMetadata);
   if (R->ParseBitcodeInto(M)) {
     if (ErrMsg)
       *ErrMsg = R->getErrorString();
@@ -2999,6 +3135,15 @@ Module *llvm::getLazyBitcodeModule(MemoryBuffer *Buffer,
   return M;
 }
 
+/// getLazyBitcodeModule - lazy function-at-a-time loading from a file.
+///
+Module *llvm::getLazyBitcodeModule(MemoryBuffer *Buffer,
+                                   LLVMContext& Context,
+                                   std::string *ErrMsg) {
+  return getLazyBitcodeModuleImpl(Buffer, Context, ErrMsg,
+                                  /*LazyMetadata=*/true);
+}
+
 
 Module *llvm::getStreamedBitcodeModule(const std::string &name,
                                        DataStreamer *streamer,
@@ -3021,7 +3166,10 @@ Module *llvm::getStreamedBitcodeModule(const std::string &name,
 /// If an error occurs, return null and fill in *ErrMsg if non-null.
 Module *llvm::ParseBitcodeFile(MemoryBuffer *Buffer, LLVMContext& Context,
                                std::string *ErrMsg){
-  Module *M = getLazyBitcodeModule(Buffer, Context, ErrMsg);
+  // The whole module is read right away, so there is nothing to gain from
+  // deferring metadata.
+  Module *M = getLazyBitcodeModuleImpl(Buffer, Context, ErrMsg,
+                                       /*LazyMetadata=*/false);
   if (!M) return 0;
 
   // Don't let the BitcodeReader dtor delete 'Buffer', regardless of whether
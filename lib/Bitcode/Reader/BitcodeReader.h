@@ -179,18 +179,35 @@ class BitcodeReader : public GVMaterializer {
   typedef std::pair<unsigned, GlobalVariable*> BlockAddrRefTy;
   DenseMap<Function*, std::vector<BlockAddrRefTy> > BlockAddrFwdRefs;
 
+  /// LazyMetadata - If set, the module-level metadata block is only indexed
+  /// when the module is parsed.  Each node or string in it is built the first
+  /// time something that is read refers to it.
+  bool LazyMetadata;
+
+  /// LazyMDOffsets - For each module-level metadata ID, the bit position of
+  /// the record defining it, or zero if it is not (or no longer) deferred.
+  std::vector<uint64_t> LazyMDOffsets;
+
+  /// LazyMDCursor - A cursor into the deferred metadata block, which holds
+  /// the abbreviations needed to read its records.
+  BitstreamCursor LazyMDCursor;
+
+  /// PendingLazyMDs - Deferred metadata IDs referenced since the last call
+  /// to materializePendingMetadata.
+  SmallVector<unsigned, 16> PendingLazyMDs;
+
 public:
   explicit BitcodeReader(MemoryBuffer *buffer, LLVMContext &C)
     : Context(C), TheModule(0), Buffer(buffer), BufferOwned(false),
       LazyStreamer(0), NextUnreadBit(0), SeenValueSymbolTable(false),
       ErrorString(0), ValueList(C), MDValueList(C),
-      SeenFirstFunctionBody(false) {
+      SeenFirstFunctionBody(false), LazyMetadata(false) {
   }
   explicit BitcodeReader(DataStreamer *streamer, LLVMContext &C)
     : Context(C), TheModule(0), Buffer(0), BufferOwned(false),
       LazyStreamer(streamer), NextUnreadBit(0), SeenValueSymbolTable(false),
       ErrorString(0), ValueList(C), MDValueList(C),
-      SeenFirstFunctionBody(false) {
+      SeenFirstFunctionBody(false), LazyMetadata(false) {
   }
   ~BitcodeReader() {
     FreeState();
@@ -203,6 +220,11 @@ public:
   /// setBufferOwned - If this is true, the reader will destroy the MemoryBuffer
   /// when the reader is destroyed.
   void setBufferOwned(bool Owned) { BufferOwned = Owned; }
+
+  /// setLazyMetadata - If this is true, module-level metadata is read on
+  /// demand as functions are materialized.  This must be set before
+  /// ParseBitcodeInto is called.
+  void setLazyMetadata(bool Lazy) { LazyMetadata = Lazy; }
   
   virtual bool isMaterializable(const GlobalValue *GV) const;
   virtual bool isDematerializable(const GlobalValue *GV) const;
@@ -225,9 +247,11 @@ public:
   bool ParseTriple(std::string &Triple);
 private:
   Type *getTypeByID(unsigned ID);
+  Value *getMDValueFwdRef(unsigned ID);
+  Value *getMDValue(unsigned ID);
   Value *getFnValueByID(unsigned ID, Type *Ty) {
     if (Ty && Ty->isMetadataTy())
-      return MDValueList.getValueFwdRef(ID);
+      return getMDValueFwdRef(ID);
     return ValueList.getValueFwdRef(ID, Ty);
   }
   BasicBlock *getBasicBlock(unsigned ID) const {
@@ -280,7 +304,11 @@ private:
   bool ParseFunctionBody(Function *F);
   bool GlobalCleanup();
   bool ResolveGlobalAndAliasInits();
-  bool ParseMetadata();
+  bool ParseMetadata(bool AllowDeferral = false);
+  bool ParseMetadataValue(unsigned Code, SmallVector<uint64_t, 64> &Record,
+                          unsigned ID);
+  bool materializePendingMetadata();
+  bool materializeAllMetadata();
   bool ParseMetadataAttachment();
   bool ParseTypeMetadataAttachment();
   bool ParseModuleTriple(std::string &Triple);
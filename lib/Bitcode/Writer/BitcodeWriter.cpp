@@ -38,6 +38,12 @@ EnablePreserveUseListOrdering("enable-bc-uselist-preserve",
                                        "use-list order preservation."),
                               cl::init(false), cl::Hidden);
 
+static cl::opt<bool>
+EnableAdaptiveAbbrevs("bitcode-adaptive-abbrevs",
+                      cl::desc("Derive extra function block abbreviations "
+                               "from the record statistics of each module."),
+                      cl::init(false), cl::Hidden);
+
 /// These are manifest constants used by the bitcode writer. They do not need to
 /// be kept in sync with the reader, but need to be consistent within this file.
 enum {
@@ -63,11 +69,249 @@ enum {
   FUNCTION_INST_RET_VOID_ABBREV,
   FUNCTION_INST_RET_VAL_ABBREV,
   FUNCTION_INST_UNREACHABLE_ABBREV,
+  FUNCTION_INST_BR_ABBREV,
+  FUNCTION_INST_BR_COND_ABBREV,
+  FUNCTION_DEBUG_LOC_ABBREV,
+  FUNCTION_DEBUG_LOC_AGAIN_ABBREV,
   
   // SwitchInst Magic
   SWITCH_INST_MAGIC = 0x4B5 // May 2012 => 1205 => Hex
 };
 
+namespace {
+/// InstAbbrevTable - Picks abbreviations for the instruction records of a
+/// module that the fixed FUNCTION_BLOCK abbreviations do not cover.  The
+/// function blocks are first written to a scratch stream while the table
+/// gathers statistics on the records, then the shapes of record that would
+/// save the most bits are given abbreviations in the BLOCKINFO block.  The
+/// reader picks these up like any other abbreviation.
+class InstAbbrevTable {
+  enum {
+    // Records with more operands than this are never abbreviated.
+    MaxOperands = 16,
+    // Value widths go up to 32, since the operands are unsigned.
+    NumWidths = 33
+  };
+
+  /// OperandStats - What was seen of one operand of a record shape.
+  struct OperandStats {
+    unsigned WidthCount[NumWidths];
+    unsigned FirstValue;
+    bool AllSame;
+  };
+
+  /// RecordShape - The statistics and the abbreviation, if any, for all the
+  /// unabbreviated records with a given code and number of operands.
+  struct RecordShape {
+    unsigned Count;
+    SmallVector<OperandStats, 4> Ops;
+    SmallVector<BitCodeAbbrevOp, 4> Encoding;
+    unsigned AbbrevID;
+    uint64_t Gain;
+    RecordShape() : Count(0), AbbrevID(0), Gain(0) {}
+  };
+
+  typedef std::map<std::pair<unsigned, unsigned>, RecordShape> ShapeMapType;
+  ShapeMapType Shapes;
+
+  /// Collecting - True while statistics are being gathered.
+  bool Collecting;
+
+  /// NumRecords - The number of records seen in function blocks, abbreviated
+  /// or not.  Each of them grows by a bit if the abbrev width is increased.
+  uint64_t NumRecords;
+
+  /// AbbrevWidth - The abbrev width to enter function blocks with.
+  unsigned AbbrevWidth;
+
+  /// Chosen - The shapes that got an abbreviation, in abbrev id order.
+  std::vector<RecordShape*> Chosen;
+
+  static unsigned getValueWidth(unsigned V) {
+    return 32 - CountLeadingZeros_32(V);
+  }
+
+  /// getVBRCost - Return the bits needed to emit a value of the given width
+  /// as a VBR with the given chunk width.
+  static uint64_t getVBRCost(unsigned ChunkWidth, unsigned ValueWidth) {
+    unsigned Chunks = ValueWidth < ChunkWidth ? 1 :
+      (ValueWidth + ChunkWidth - 2) / (ChunkWidth - 1);
+    return Chunks * ChunkWidth;
+  }
+
+  static bool compareGain(const std::pair<uint64_t, RecordShape*> &LHS,
+                          const std::pair<uint64_t, RecordShape*> &RHS) {
+    return LHS.first > RHS.first;
+  }
+
+  static bool fitsOperand(const BitCodeAbbrevOp &Op, unsigned V);
+  static uint64_t chooseOperandEncoding(const OperandStats &S, unsigned Count,
+                                        SmallVectorImpl<BitCodeAbbrevOp> &Ops);
+public:
+  InstAbbrevTable() : Collecting(false), NumRecords(0), AbbrevWidth(4) {}
+
+  void startCollecting() { Collecting = true; }
+
+  /// chooseAbbrevs - Stop gathering statistics and decide which record shapes
+  /// to abbreviate.
+  void chooseAbbrevs();
+
+  /// emitAbbrevs - Emit the chosen abbreviations to the BLOCKINFO block.
+  void emitAbbrevs(BitstreamWriter &Stream);
+
+  unsigned getAbbrevWidth() const { return AbbrevWidth; }
+
+  /// getAbbrev - Return the abbreviation to emit the given function block
+  /// record with.  AbbrevToUse is the one picked by the caller, or zero.
+  unsigned getAbbrev(unsigned Code, const SmallVectorImpl<unsigned> &Vals,
+                     unsigned AbbrevToUse);
+};
+}
+
+bool InstAbbrevTable::fitsOperand(const BitCodeAbbrevOp &Op, unsigned V) {
+  if (Op.isLiteral())
+    return Op.getLiteralValue() == V;
+  if (Op.getEncoding() == BitCodeAbbrevOp::Fixed)
+    return getValueWidth(V) <= Op.getEncodingData();
+  return true;
+}
+
+/// chooseOperandEncoding - Add the cheapest encoding for an operand to Ops and
+/// return the bits it takes for all Count records.
+uint64_t
+InstAbbrevTable::chooseOperandEncoding(const OperandStats &S, unsigned Count,
+                                       SmallVectorImpl<BitCodeAbbrevOp> &Ops) {
+  if (S.AllSame) {
+    Ops.push_back(BitCodeAbbrevOp(S.FirstValue));
+    return 0;
+  }
+
+  unsigned MaxWidth = 1;
+  for (unsigned W = 0; W != NumWidths; ++W)
+    if (S.WidthCount[W])
+      MaxWidth = std::max(MaxWidth, W);
+
+  BitCodeAbbrevOp Best(BitCodeAbbrevOp::Fixed, MaxWidth);
+  uint64_t BestCost = uint64_t(MaxWidth) * Count;
+  for (unsigned ChunkWidth = 2; ChunkWidth <= 32; ++ChunkWidth) {
+    uint64_t Cost = 0;
+    for (unsigned W = 0; W != NumWidths; ++W)
+      Cost += S.WidthCount[W] * getVBRCost(ChunkWidth, W);
+    if (Cost < BestCost) {
+      Best = BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, ChunkWidth);
+      BestCost = Cost;
+    }
+  }
+  Ops.push_back(Best);
+  return BestCost;
+}
+
+void InstAbbrevTable::chooseAbbrevs() {
+  Collecting = false;
+
+  // Work out what each shape would save with the best abbreviation for it.
+  std::vector<std::pair<uint64_t, RecordShape*> > Candidates;
+  for (ShapeMapType::iterator I = Shapes.begin(), E = Shapes.end();
+       I != E; ++I) {
+    RecordShape &Shape = I->second;
+    unsigned NumOps = Shape.Ops.size();
+
+    // Unabbreviated, the code, the operand count and each operand are 6-bit
+    // VBRs.
+    uint64_t OldCost = Shape.Count *
+      (getVBRCost(6, getValueWidth(I->first.first)) +
+       getVBRCost(6, getValueWidth(NumOps)));
+    uint64_t NewCost = 0;
+    Shape.Encoding.push_back(BitCodeAbbrevOp(I->first.first));
+    for (unsigned i = 0; i != NumOps; ++i) {
+      const OperandStats &S = Shape.Ops[i];
+      for (unsigned W = 0; W != NumWidths; ++W)
+        OldCost += S.WidthCount[W] * getVBRCost(6, W);
+      NewCost += chooseOperandEncoding(S, Shape.Count, Shape.Encoding);
+    }
+
+    // Roughly what the definition costs in the BLOCKINFO block.
+    NewCost += 16 + 10 * NumOps;
+    if (NewCost < OldCost) {
+      Shape.Gain = OldCost - NewCost;
+      Candidates.push_back(std::make_pair(Shape.Gain, &Shape));
+    }
+  }
+  std::stable_sort(Candidates.begin(), Candidates.end(), compareGain);
+
+  // The fixed abbreviations leave room for one more with the default 4-bit
+  // abbrev ids.  A 5-bit width makes room for many more, but costs a bit on
+  // every record in every function block.
+  unsigned FreeIDs4 = 16 - (FUNCTION_DEBUG_LOC_AGAIN_ABBREV + 1);
+  unsigned FreeIDs5 = 32 - (FUNCTION_DEBUG_LOC_AGAIN_ABBREV + 1);
+  uint64_t Gain4 = 0, Gain5 = 0;
+  for (unsigned i = 0, e = Candidates.size(); i != e; ++i) {
+    if (i < FreeIDs4)
+      Gain4 += Candidates[i].first;
+    if (i < FreeIDs5)
+      Gain5 += Candidates[i].first;
+  }
+
+  unsigned NumToUse = std::min<unsigned>(FreeIDs4, Candidates.size());
+  if (Gain5 > Gain4 + NumRecords) {
+    AbbrevWidth = 5;
+    NumToUse = std::min<unsigned>(FreeIDs5, Candidates.size());
+  }
+  for (unsigned i = 0; i != NumToUse; ++i)
+    Chosen.push_back(Candidates[i].second);
+}
+
+void InstAbbrevTable::emitAbbrevs(BitstreamWriter &Stream) {
+  for (unsigned i = 0, e = Chosen.size(); i != e; ++i) {
+    RecordShape &Shape = *Chosen[i];
+    BitCodeAbbrev *Abbv = new BitCodeAbbrev();
+    for (unsigned j = 0, je = Shape.Encoding.size(); j != je; ++j)
+      Abbv->Add(Shape.Encoding[j]);
+    Shape.AbbrevID = Stream.EmitBlockInfoAbbrev(bitc::FUNCTION_BLOCK_ID, Abbv);
+  }
+}
+
+unsigned InstAbbrevTable::getAbbrev(unsigned Code,
+                                    const SmallVectorImpl<unsigned> &Vals,
+                                    unsigned AbbrevToUse) {
+  if (Collecting) {
+    ++NumRecords;
+    if (AbbrevToUse || Vals.size() > MaxOperands)
+      return AbbrevToUse;
+
+    RecordShape &Shape = Shapes[std::make_pair(Code, Vals.size())];
+    if (Shape.Count++ == 0) {
+      Shape.Ops.resize(Vals.size());
+      for (unsigned i = 0, e = Vals.size(); i != e; ++i) {
+        OperandStats &S = Shape.Ops[i];
+        std::fill(S.WidthCount, S.WidthCount + NumWidths, 0);
+        S.FirstValue = Vals[i];
+        S.AllSame = true;
+      }
+    }
+    for (unsigned i = 0, e = Vals.size(); i != e; ++i) {
+      OperandStats &S = Shape.Ops[i];
+      ++S.WidthCount[getValueWidth(Vals[i])];
+      S.AllSame &= S.FirstValue == Vals[i];
+    }
+    return AbbrevToUse;
+  }
+
+  if (AbbrevToUse || Chosen.empty())
+    return AbbrevToUse;
+
+  ShapeMapType::iterator I = Shapes.find(std::make_pair(Code, Vals.size()));
+  if (I == Shapes.end() || !I->second.AbbrevID)
+    return 0;
+
+  // The records are the same ones the statistics came from, but make sure.
+  const RecordShape &Shape = I->second;
+  for (unsigned i = 0, e = Vals.size(); i != e; ++i)
+    if (!fitsOperand(Shape.Encoding[i+1], Vals[i]))
+      return 0;
+  return Shape.AbbrevID;
+}
+
 static unsigned GetEncodedCastOpcode(unsigned Opcode) {
   switch (Opcode) {
   default: llvm_unreachable("Unknown cast instruction!");
@@ -1069,7 +1313,8 @@ static bool PushValueAndType(const Value *V, unsigned InstID,
 /// WriteInstruction - Emit an instruction to the specified stream.
 static void WriteInstruction(const Instruction &I, unsigned InstID,
                              ValueEnumerator &VE, BitstreamWriter &Stream,
-                             SmallVector<unsigned, 64> &Vals) {
+                             SmallVector<unsigned, 64> &Vals,
+                             InstAbbrevTable &InstAbbrevs) {
   unsigned Code = 0;
   unsigned AbbrevToUse = 0;
   VE.setInstructionID(&I);
@@ -1173,9 +1418,11 @@ static void WriteInstruction(const Instruction &I, unsigned InstID,
       Code = bitc::FUNC_CODE_INST_BR;
       BranchInst &II = cast<BranchInst>(I);
       Vals.push_back(VE.getValueID(II.getSuccessor(0)));
+      AbbrevToUse = FUNCTION_INST_BR_ABBREV;
       if (II.isConditional()) {
         Vals.push_back(VE.getValueID(II.getSuccessor(1)));
         Vals.push_back(VE.getValueID(II.getCondition()));
+        AbbrevToUse = FUNCTION_INST_BR_COND_ABBREV;
       }
     }
     break;
@@ -1405,6 +1652,7 @@ static void WriteInstruction(const Instruction &I, unsigned InstID,
     break;
   }
 
+  AbbrevToUse = InstAbbrevs.getAbbrev(Code, Vals, AbbrevToUse);
   Stream.EmitRecord(Code, Vals, AbbrevToUse);
   Vals.clear();
 }
@@ -1469,8 +1717,9 @@ static void WriteValueSymbolTable(const ValueSymbolTable &VST,
 
 /// WriteFunction - Emit a function body to the module stream.
 static void WriteFunction(const Function &F, ValueEnumerator &VE,
-                          BitstreamWriter &Stream) {
-  Stream.EnterSubblock(bitc::FUNCTION_BLOCK_ID, 4);
+                          BitstreamWriter &Stream,
+                          InstAbbrevTable &InstAbbrevs) {
+  Stream.EnterSubblock(bitc::FUNCTION_BLOCK_ID, InstAbbrevs.getAbbrevWidth());
   VE.incorporateFunction(F);
 
   SmallVector<unsigned, 64> Vals;
@@ -1500,7 +1749,7 @@ static void WriteFunction(const Function &F, ValueEnumerator &VE,
   for (Function::const_iterator BB = F.begin(), E = F.end(); BB != E; ++BB)
     for (BasicBlock::const_iterator I = BB->begin(), E = BB->end();
          I != E; ++I) {
-      WriteInstruction(*I, InstID, VE, Stream, Vals);
+      WriteInstruction(*I, InstID, VE, Stream, Vals, InstAbbrevs);
       
       if (!I->getType()->isVoidTy())
         ++InstID;
@@ -1514,7 +1763,11 @@ static void WriteFunction(const Function &F, ValueEnumerator &VE,
         // nothing todo.
       } else if (DL == LastDL) {
         // Just repeat the same debug loc as last time.
-        Stream.EmitRecord(bitc::FUNC_CODE_DEBUG_LOC_AGAIN, Vals);
+        unsigned Abbrev = FUNCTION_DEBUG_LOC_AGAIN_ABBREV;
+        Abbrev = InstAbbrevs.getAbbrev(bitc::FUNC_CODE_DEBUG_LOC_AGAIN, Vals,
+                                       Abbrev);
+        Stream.EmitRecord(bitc::FUNC_CODE_DEBUG_LOC_AGAIN, Vals, Abbrev);
+        Vals.clear();
       } else {
         MDNode *Scope, *IA;
         DL.getScopeAndInlinedAt(Scope, IA, I->getContext());
@@ -1523,7 +1776,9 @@ static void WriteFunction(const Function &F, ValueEnumerator &VE,
         Vals.push_back(DL.getCol());
         Vals.push_back(Scope ? VE.getValueID(Scope)+1 : 0);
         Vals.push_back(IA ? VE.getValueID(IA)+1 : 0);
-        Stream.EmitRecord(bitc::FUNC_CODE_DEBUG_LOC, Vals);
+        Stream.EmitRecord(bitc::FUNC_CODE_DEBUG_LOC, Vals,
+                          InstAbbrevs.getAbbrev(bitc::FUNC_CODE_DEBUG_LOC, Vals,
+                                                FUNCTION_DEBUG_LOC_ABBREV));
         Vals.clear();
         
         LastDL = DL;
@@ -1540,7 +1795,8 @@ static void WriteFunction(const Function &F, ValueEnumerator &VE,
 }
 
 // Emit blockinfo, which defines the standard abbreviations etc.
-static void WriteBlockInfo(const ValueEnumerator &VE, BitstreamWriter &Stream) {
+static void WriteBlockInfo(const ValueEnumerator &VE, BitstreamWriter &Stream,
+                           InstAbbrevTable &InstAbbrevs) {
   // We only want to emit block info records for blocks that have multiple
   // instances: CONSTANTS_BLOCK, FUNCTION_BLOCK and VALUE_SYMTAB_BLOCK.  Other
   // blocks can defined their abbrevs inline.
@@ -1696,6 +1952,45 @@ static void WriteBlockInfo(const ValueEnumerator &VE, BitstreamWriter &Stream) {
                                    Abbv) != FUNCTION_INST_UNREACHABLE_ABBREV)
       llvm_unreachable("Unexpected abbrev ordering!");
   }
+  { // Unconditional INST_BR abbrev for FUNCTION_BLOCK.
+    BitCodeAbbrev *Abbv = new BitCodeAbbrev();
+    Abbv->Add(BitCodeAbbrevOp(bitc::FUNC_CODE_INST_BR));
+    Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6)); // dest
+    if (Stream.EmitBlockInfoAbbrev(bitc::FUNCTION_BLOCK_ID,
+                                   Abbv) != FUNCTION_INST_BR_ABBREV)
+      llvm_unreachable("Unexpected abbrev ordering!");
+  }
+  { // Conditional INST_BR abbrev for FUNCTION_BLOCK.
+    BitCodeAbbrev *Abbv = new BitCodeAbbrev();
+    Abbv->Add(BitCodeAbbrevOp(bitc::FUNC_CODE_INST_BR));
+    Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6)); // true dest
+    Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6)); // false dest
+    Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6)); // cond
+    if (Stream.EmitBlockInfoAbbrev(bitc::FUNCTION_BLOCK_ID,
+                                   Abbv) != FUNCTION_INST_BR_COND_ABBREV)
+      llvm_unreachable("Unexpected abbrev ordering!");
+  }
+  { // DEBUG_LOC abbrev for FUNCTION_BLOCK.
+    BitCodeAbbrev *Abbv = new BitCodeAbbrev();
+    Abbv->Add(BitCodeAbbrevOp(bitc::FUNC_CODE_DEBUG_LOC));
+    Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 8)); // line
+    Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6)); // col
+    Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6)); // scope
+    Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6)); // inlined-at
+    if (Stream.EmitBlockInfoAbbrev(bitc::FUNCTION_BLOCK_ID,
+                                   Abbv) != FUNCTION_DEBUG_LOC_ABBREV)
+      llvm_unreachable("Unexpected abbrev ordering!");
+  }
+  { // DEBUG_LOC_AGAIN abbrev for FUNCTION_BLOCK.
+    BitCodeAbbrev *Abbv = new BitCodeAbbrev();
+    Abbv->Add(BitCodeAbbrevOp(bitc::FUNC_CODE_DEBUG_LOC_AGAIN));
+    if (Stream.EmitBlockInfoAbbrev(bitc::FUNCTION_BLOCK_ID,
+                                   Abbv) != FUNCTION_DEBUG_LOC_AGAIN_ABBREV)
+      llvm_unreachable("Unexpected abbrev ordering!");
+  }
+
+  // Add the abbreviations derived for this module, if any.
+  InstAbbrevs.emitAbbrevs(Stream);
 
   Stream.ExitBlock();
 }
@@ -1811,8 +2106,24 @@ static void WriteModule(const Module *M, BitstreamWriter &Stream) {
   // Analyze the module, enumerating globals, functions, etc.
   ValueEnumerator VE(M);
 
+  // If asked to, write the function bodies to a scratch stream first to find
+  // out which records are worth abbreviating.
+  InstAbbrevTable InstAbbrevs;
+  if (EnableAdaptiveAbbrevs) {
+    SmallVector<char, 0> Scratch;
+    BitstreamWriter ScratchStream(Scratch);
+    InstAbbrevs.startCollecting();
+    WriteBlockInfo(VE, ScratchStream, InstAbbrevs);
+    for (Module::const_iterator F = M->begin(), E = M->end(); F != E; ++F)
+      if (!F->isDeclaration()) {
+        WriteFunction(*F, VE, ScratchStream, InstAbbrevs);
+        Scratch.clear();
+      }
+    InstAbbrevs.chooseAbbrevs();
+  }
+
   // Emit blockinfo, which defines the standard abbreviations etc.
-  WriteBlockInfo(VE, Stream);
+  WriteBlockInfo(VE, Stream, InstAbbrevs);
 
   // Emit information about parameter attributes.
   WriteAttributeTable(VE, Stream);
@@ -1840,10 +2151,18 @@ static void WriteModule(const Module *M, BitstreamWriter &Stream) {
   if (EnablePreserveUseListOrdering)
     WriteModuleUseLists(M, VE, Stream);
 
-  // Emit function bodies.
+  // Emit function bodies.  Each is encoded into a buffer of its own and then
+  // spliced into the module block.
+  SmallVector<char, 0> FunctionBuffer;
+  BitstreamWriter FunctionStream(FunctionBuffer);
+  FunctionStream.CopyBlockInfo(Stream);
   for (Module::const_iterator F = M->begin(), E = M->end(); F != E; ++F)
-    if (!F->isDeclaration())
-      WriteFunction(*F, VE, Stream);
+    if (!F->isDeclaration()) {
+      WriteFunction(*F, VE, FunctionStream, InstAbbrevs);
+      Stream.EmitSubblock(bitc::FUNCTION_BLOCK_ID,
+                          InstAbbrevs.getAbbrevWidth(), FunctionBuffer);
+      FunctionBuffer.clear();
+    }
 
   Stream.ExitBlock();
 }
@@ -67,6 +67,10 @@ ValueEnumerator::ValueEnumerator(const Module *M) {
 
   SmallVector<std::pair<unsigned, MDNode*>, 8> MDs;
 
+  // Consecutive instructions usually share a debug location, so only look up
+  // its scopes when it changes.
+  DebugLoc LastDL;
+
   // Enumerate types used by function bodies and argument lists.
   for (Module::const_iterator F = M->begin(), E = M->end(); F != E; ++F) {
 
@@ -96,11 +100,13 @@ ValueEnumerator::ValueEnumerator(const Module *M) {
         for (unsigned i = 0, e = MDs.size(); i != e; ++i)
           EnumerateMetadata(MDs[i].second);
         
-        if (!I->getDebugLoc().isUnknown()) {
+        const DebugLoc &DL = I->getDebugLoc();
+        if (!DL.isUnknown() && DL != LastDL) {
           MDNode *Scope, *IA;
-          I->getDebugLoc().getScopeAndInlinedAt(Scope, IA, I->getContext());
+          DL.getScopeAndInlinedAt(Scope, IA, I->getContext());
           if (Scope) EnumerateMetadata(Scope);
           if (IA) EnumerateMetadata(IA);
+          LastDL = DL;
         }
       }
   }
@@ -67,7 +67,7 @@ LiveVariables::VarInfo::findKill(const MachineBasicBlock *MBB) const {
 void LiveVariables::VarInfo::dump() const {
 #if !defined(NDEBUG) || defined(LLVM_ENABLE_DUMP)
   dbgs() << "  Alive in blocks: ";
-  for (SparseBitVector<>::iterator I = AliveBlocks.begin(),
+  for (FlatSparseBitVector<>::iterator I = AliveBlocks.begin(),
            E = AliveBlocks.end(); I != E; ++I)
     dbgs() << *I << ", ";
   dbgs() << "\n  Killed by:";
@@ -917,7 +917,9 @@ void SelectionDAG::allnodes_clear() {
 
 void SelectionDAG::clear() {
   allnodes_clear();
-  OperandAllocator.Reset();
+  // The DAG is cleared once per basic block, and the next block usually needs
+  // about as many operands, so keep the slabs around.
+  OperandAllocator.Reset(/*KeepSlabs=*/true);
   CSEMap.clear();
 
   ExtendedValueTypeNodes.clear();
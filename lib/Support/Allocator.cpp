@@ -7,13 +7,16 @@
 //
 //===----------------------------------------------------------------------===//
 //
-// This file implements the BumpPtrAllocator interface.
+// This file implements the BumpPtrAllocator and ThreadLocalBumpPtrAllocator
+// interfaces.
 //
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Support/Allocator.h"
 #include "llvm/Support/DataTypes.h"
+#include "llvm/Support/MutexGuard.h"
 #include "llvm/Support/Recycler.h"
+#include "llvm/Support/ThreadLocalAllocator.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/Memory.h"
 #include <cstring>
@@ -23,10 +26,12 @@ namespace llvm {
 BumpPtrAllocator::BumpPtrAllocator(size_t size, size_t threshold,
                                    SlabAllocator &allocator)
     : SlabSize(size), SizeThreshold(std::min(size, threshold)),
-      Allocator(allocator), CurSlab(0), BytesAllocated(0) { }
+      Allocator(allocator), CurSlab(0), FreeSlabs(0), BytesAllocated(0),
+      AlignmentWaste(0), SlabTailWaste(0) { }
 
 BumpPtrAllocator::~BumpPtrAllocator() {
   DeallocateSlabs(CurSlab);
+  DeallocateSlabs(FreeSlabs);
 }
 
 /// AlignPtr - Align Ptr to Alignment bytes, rounding up.  Alignment should
@@ -50,7 +55,12 @@ void BumpPtrAllocator::StartNewSlab() {
   if (BytesAllocated >= SlabSize * 128)
     SlabSize *= 2;
 
-  MemSlab *NewSlab = Allocator.Allocate(SlabSize);
+  // Reuse a slab kept by Reset if there is one.
+  MemSlab *NewSlab = FreeSlabs;
+  if (NewSlab)
+    FreeSlabs = NewSlab->NextPtr;
+  else
+    NewSlab = Allocator.Allocate(SlabSize);
   NewSlab->NextPtr = CurSlab;
   CurSlab = NewSlab;
   CurPtr = (char*)(CurSlab + 1);
@@ -74,11 +84,27 @@ void BumpPtrAllocator::DeallocateSlabs(MemSlab *Slab) {
 }
 
 /// Reset - Deallocate all but the current slab and reset the current pointer
-/// to the beginning of it, freeing all memory allocated so far.
-void BumpPtrAllocator::Reset() {
+/// to the beginning of it, freeing all memory allocated so far.  If KeepSlabs
+/// is true, the other slabs are kept for reuse.
+void BumpPtrAllocator::Reset(bool KeepSlabs) {
+  if (!KeepSlabs) {
+    DeallocateSlabs(FreeSlabs);
+    FreeSlabs = 0;
+  }
   if (!CurSlab)
     return;
-  DeallocateSlabs(CurSlab->NextPtr);
+  if (KeepSlabs) {
+    // Splice the rest of the chain onto the free list.
+    if (MemSlab *Rest = CurSlab->NextPtr) {
+      MemSlab *Last = Rest;
+      while (Last->NextPtr)
+        Last = Last->NextPtr;
+      Last->NextPtr = FreeSlabs;
+      FreeSlabs = Rest;
+    }
+  } else {
+    DeallocateSlabs(CurSlab->NextPtr);
+  }
   CurSlab->NextPtr = 0;
   CurPtr = (char*)(CurSlab + 1);
   End = ((char*)CurSlab) + CurSlab->Size;
@@ -101,6 +127,7 @@ void *BumpPtrAllocator::Allocate(size_t Size, size_t Alignment) {
 
   // Check if we can hold it.
   if (Ptr + Size <= End) {
+    AlignmentWaste += Ptr - CurPtr;
     CurPtr = Ptr + Size;
     return Ptr;
   }
@@ -117,12 +144,15 @@ void *BumpPtrAllocator::Allocate(size_t Size, size_t Alignment) {
 
     Ptr = AlignPtr((char*)(NewSlab + 1), Alignment);
     assert((uintptr_t)Ptr + Size <= (uintptr_t)NewSlab + NewSlab->Size);
+    AlignmentWaste += Ptr - (char*)(NewSlab + 1);
     return Ptr;
   }
 
   // Otherwise, start a new slab and try again.
+  SlabTailWaste += End - CurPtr;
   StartNewSlab();
   Ptr = AlignPtr(CurPtr, Alignment);
+  AlignmentWaste += Ptr - CurPtr;
   CurPtr = Ptr + Size;
   assert(CurPtr <= End && "Unable to allocate memory!");
   return Ptr;
@@ -141,6 +171,9 @@ size_t BumpPtrAllocator::getTotalMemory() const {
   for (MemSlab *Slab = CurSlab; Slab != 0; Slab = Slab->NextPtr) {
     TotalMemory += Slab->Size;
   }
+  for (MemSlab *Slab = FreeSlabs; Slab != 0; Slab = Slab->NextPtr) {
+    TotalMemory += Slab->Size;
+  }
   return TotalMemory;
 }
   
@@ -151,12 +184,83 @@ void BumpPtrAllocator::PrintStats() const {
     TotalMemory += Slab->Size;
     ++NumSlabs;
   }
+  unsigned NumFreeSlabs = 0;
+  size_t FreeMemory = 0;
+  for (MemSlab *Slab = FreeSlabs; Slab != 0; Slab = Slab->NextPtr) {
+    FreeMemory += Slab->Size;
+    ++NumFreeSlabs;
+  }
 
   errs() << "\nNumber of memory regions: " << NumSlabs << '\n'
          << "Bytes used: " << BytesAllocated << '\n'
          << "Bytes allocated: " << TotalMemory << '\n'
          << "Bytes wasted: " << (TotalMemory - BytesAllocated)
-         << " (includes alignment, etc)\n";
+         << " (includes alignment, etc)\n"
+         << "Bytes wasted to alignment: " << AlignmentWaste << '\n'
+         << "Bytes wasted in slab tails: " << SlabTailWaste << '\n'
+         << "Memory regions kept for reuse: " << NumFreeSlabs
+         << " (" << FreeMemory << " bytes)\n";
+}
+
+ThreadLocalBumpPtrAllocator::ThreadLocalBumpPtrAllocator(size_t size,
+                                                         size_t threshold,
+                                                     SlabAllocator &allocator)
+    : SlabSize(size), SizeThreshold(threshold), Allocator(allocator) { }
+
+ThreadLocalBumpPtrAllocator::~ThreadLocalBumpPtrAllocator() {
+  for (unsigned i = 0, e = Allocators.size(); i != e; ++i)
+    delete Allocators[i];
+}
+
+BumpPtrAllocator &ThreadLocalBumpPtrAllocator::createThreadAllocator() {
+  BumpPtrAllocator *A = new BumpPtrAllocator(SlabSize, SizeThreshold,
+                                             Allocator);
+  {
+    MutexGuard Guard(Lock);
+    Allocators.push_back(A);
+  }
+  Current.set(A);
+  return *A;
+}
+
+void ThreadLocalBumpPtrAllocator::Reset(bool KeepSlabs) {
+  MutexGuard Guard(Lock);
+  for (unsigned i = 0, e = Allocators.size(); i != e; ++i)
+    Allocators[i]->Reset(KeepSlabs);
+}
+
+size_t ThreadLocalBumpPtrAllocator::getTotalMemory() const {
+  size_t Total = 0;
+  for (unsigned i = 0, e = Allocators.size(); i != e; ++i)
+    Total += Allocators[i]->getTotalMemory();
+  return Total;
+}
+
+size_t ThreadLocalBumpPtrAllocator::getBytesAllocated() const {
+  size_t Total = 0;
+  for (unsigned i = 0, e = Allocators.size(); i != e; ++i)
+    Total += Allocators[i]->getBytesAllocated();
+  return Total;
+}
+
+size_t ThreadLocalBumpPtrAllocator::getAlignmentWaste() const {
+  size_t Total = 0;
+  for (unsigned i = 0, e = Allocators.size(); i != e; ++i)
+    Total += Allocators[i]->getAlignmentWaste();
+  return Total;
+}
+
+size_t ThreadLocalBumpPtrAllocator::getSlabTailWaste() const {
+  size_t Total = 0;
+  for (unsigned i = 0, e = Allocators.size(); i != e; ++i)
+    Total += Allocators[i]->getSlabTailWaste();
+  return Total;
+}
+
+void ThreadLocalBumpPtrAllocator::PrintStats() const {
+  errs() << "\nNumber of thread allocators: " << Allocators.size() << '\n';
+  for (unsigned i = 0, e = Allocators.size(); i != e; ++i)
+    Allocators[i]->PrintStats();
 }
 
 MallocSlabAllocator BumpPtrAllocator::DefaultSlabAllocator =
@@ -177,6 +281,10 @@ void MallocSlabAllocator::Deallocate(MemSlab *Slab) {
   Allocator.Deallocate(Slab);
 }
 
+void PrintSizeClassStats(size_t FreeBytes) {
+  errs() << "Bytes free for recycling: " << FreeBytes << '\n';
+}
+
 void PrintRecyclerStats(size_t Size,
                         size_t Align,
                         size_t FreeListSize) {
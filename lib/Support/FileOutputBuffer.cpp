@@ -18,6 +18,8 @@
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/system_error.h"
+#include <algorithm>
+#include <cstring>
 
 
 namespace llvm {
@@ -131,16 +133,128 @@ error_code FileOutputBuffer::commit(int64_t NewSmallerSize) {
   error_code EC = sys::fs::unmap_file_pages(Start, getBufferSize());
   if (EC)
     return EC;
+  // The range is gone, make sure the destructor does not unmap it again.
+  BufferStart = BufferEnd = NULL;
   
   // If requested, resize file as part of commit.
-  if ( NewSmallerSize != -1 ) {
+  if ( NewSmallerSize != -1 )
     EC = sys::fs::resize_file(Twine(TempPath), NewSmallerSize);
-    if (EC)
-      return EC;
-  }
-  
+
   // Rename file to final name.
-  return sys::fs::rename(Twine(TempPath), Twine(FinalPath));
+  if (!EC)
+    EC = sys::fs::rename(Twine(TempPath), Twine(FinalPath));
+
+  // The destructor no longer cleans up, so do not leave the temp file behind.
+  if (EC) {
+    bool Existed;
+    sys::fs::remove(Twine(TempPath), Existed);
+  }
+  return EC;
+}
+
+
+error_code FileOutputBuffer::extend(size_t NewSize) {
+  size_t OldSize = getBufferSize();
+  if (NewSize <= OldSize)
+    return error_code::success();
+
+  // Remap the file at its new size.  The pages written so far stay in the
+  // file, so nothing is copied.
+  error_code EC = sys::fs::unmap_file_pages(BufferStart, OldSize);
+  void *Base = NULL;
+  if (!EC)
+    EC = sys::fs::resize_file(Twine(TempPath), NewSize);
+  if (!EC)
+    EC = sys::fs::map_file_pages(Twine(TempPath), 0, NewSize, true, Base);
+  if (EC) {
+    BufferStart = BufferEnd = NULL;
+    bool Existed;
+    sys::fs::remove(Twine(TempPath), Existed);
+    return EC;
+  }
+
+  BufferStart = reinterpret_cast<uint8_t*>(Base);
+  BufferEnd = BufferStart + NewSize;
+  return error_code::success();
+}
+
+
+raw_mmap_ostream::raw_mmap_ostream(StringRef Path, std::string &ErrorInfo,
+                                   size_t SizeHint, unsigned Flags)
+  : Pos(0) {
+  ErrorInfo.clear();
+  // Start with a reasonably large mapping; pages that are never touched cost
+  // nothing and commit() trims the file.
+  EC = FileOutputBuffer::create(Path, std::max<size_t>(SizeHint, 1 << 20),
+                                Buffer, Flags);
+  if (EC) {
+    ErrorInfo = "Error opening output file '" + Path.str() + "': " +
+                EC.message();
+    SetUnbuffered();
+    return;
+  }
+  SetBuffer(reinterpret_cast<char*>(Buffer->getBufferStart()),
+            Buffer->getBufferSize());
+}
+
+raw_mmap_ostream::~raw_mmap_ostream() {
+  // Empty the stream buffer as raw_ostream expects.  Without a commit the
+  // FileOutputBuffer throws the output away along with the temporary file.
+  SetUnbuffered();
+}
+
+bool raw_mmap_ostream::reserve(size_t Size) {
+  if (Size <= Buffer->getBufferSize())
+    return true;
+  size_t NewSize = std::max(Size, 2 * Buffer->getBufferSize());
+  EC = Buffer->extend(NewSize);
+  if (!EC)
+    return true;
+  Buffer.reset();
+  return false;
+}
+
+void raw_mmap_ostream::write_impl(const char *Ptr, size_t Size) {
+  // After an error, output is dropped.
+  if (!Buffer)
+    return;
+
+  // If the stream is buffered, the buffer is the rest of the mapping and the
+  // bytes are usually in place already.  Otherwise, e.g. when the stream is
+  // unbuffered or for large writes that bypass the buffer, copy them in.
+  bool Buffered = getBufferStart() != 0;
+  char *Cur = reinterpret_cast<char*>(Buffer->getBufferStart()) + Pos;
+  if (Ptr != Cur) {
+    assert(GetNumBytesInBuffer() == 0 &&
+           "Should be writing from buffer if some bytes in it");
+    if (!reserve(Pos + Size)) {
+      SetUnbuffered();
+      return;
+    }
+    memcpy(Buffer->getBufferStart() + Pos, Ptr, Size);
+  }
+  Pos += Size;
+
+  if (!Buffered)
+    return;
+
+  // Keep some room ahead to buffer into.
+  if (Buffer->getBufferSize() - Pos < 4096 && !reserve(Pos + 4096)) {
+    SetUnbuffered();
+    return;
+  }
+  SetBuffer(reinterpret_cast<char*>(Buffer->getBufferStart()) + Pos,
+            Buffer->getBufferSize() - Pos);
+}
+
+error_code raw_mmap_ostream::commit() {
+  flush();
+  if (!Buffer)
+    return EC;
+  SetUnbuffered();
+  EC = Buffer->commit(Pos);
+  Buffer.reset();
+  return EC;
 }
 
 
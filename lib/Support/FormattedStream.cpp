@@ -72,7 +72,7 @@ void formatted_raw_ostream::write_impl(const char *Ptr, size_t Size) {
   ComputeColumn(Ptr, Size);
 
   // Write the data to the underlying stream (which is unbuffered, so
-  // the data will be immediately written out).
+  // the data will be immediately written out, unless we kept its buffer).
   TheStream->write(Ptr, Size);
 
   // Reset the scanning pointer.
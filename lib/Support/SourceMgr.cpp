@@ -19,13 +19,33 @@
 #include "llvm/ADT/OwningPtr.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/system_error.h"
+#include <algorithm>
+#include <cstring>
 using namespace llvm;
 
 namespace {
+  /// LineOffsetIndex - The offsets of the newlines in a prefix of a buffer.
+  /// The prefix is extended as later locations are queried, so the buffer is
+  /// scanned at most once and any location in the prefix is found with a
+  /// binary search.  Buffers under 4GB record 32-bit offsets to halve the
+  /// footprint.
+  struct LineOffsetIndex {
+    size_t Scanned;
+    std::vector<uint32_t> Newlines32;
+    std::vector<uint64_t> Newlines64;
+
+    LineOffsetIndex() : Scanned(0) {}
+  };
+
   struct LineNoCacheTy {
-    int LastQueryBufferID;
-    const char *LastQuery;
-    unsigned LineNoOfQuery;
+    /// Buffers - The index for each buffer ID queried so far, or null.  These
+    /// are pointers so that adding a buffer does not copy the others.
+    std::vector<LineOffsetIndex*> Buffers;
+
+    ~LineNoCacheTy() {
+      for (unsigned i = 0, e = Buffers.size(); i != e; ++i)
+        delete Buffers[i];
+    }
   };
 }
 
@@ -33,6 +53,22 @@ static LineNoCacheTy *getCache(void *Ptr) {
   return (LineNoCacheTy*)Ptr;
 }
 
+/// getLineNumber - Return the 1-based line of Offset in the buffer starting at
+/// BufStart, recording the newlines up to Offset if they are not known yet.
+template<typename OffsetTy>
+static unsigned getLineNumber(std::vector<OffsetTy> &Newlines, size_t &Scanned,
+                              const char *BufStart, size_t Offset) {
+  if (Offset > Scanned) {
+    const char *End = BufStart + Offset;
+    for (const char *P = BufStart + Scanned;
+         (P = (const char*)memchr(P, '\n', End - P)); ++P)
+      Newlines.push_back(OffsetTy(P - BufStart));
+    Scanned = Offset;
+  }
+  return std::lower_bound(Newlines.begin(), Newlines.end(), OffsetTy(Offset)) -
+         Newlines.begin() + 1;
+}
+
 
 SourceMgr::~SourceMgr() {
   // Delete the line # cache if allocated.
@@ -80,7 +116,7 @@ int SourceMgr::FindBufferContainingLoc(SMLoc Loc) const {
 }
 
 /// getLineAndColumn - Find the line and column number for the specified
-/// location in the specified file.  This is not a fast method.
+/// location in the specified file.
 std::pair<unsigned, unsigned>
 SourceMgr::getLineAndColumn(SMLoc Loc, int BufferID) const {
   if (BufferID == -1) BufferID = FindBufferContainingLoc(Loc);
@@ -88,38 +124,28 @@ SourceMgr::getLineAndColumn(SMLoc Loc, int BufferID) const {
 
   MemoryBuffer *Buff = getBufferInfo(BufferID).Buffer;
 
-  // Count the number of \n's between the start of the file and the specified
-  // location.
-  unsigned LineNo = 1;
-
   const char *BufStart = Buff->getBufferStart();
-  const char *Ptr = BufStart;
-
-  // If we have a line number cache, and if the query is to a later point in the
-  // same file, start searching from the last query location.  This optimizes
-  // for the case when multiple diagnostics come out of one file in order.
-  if (LineNoCacheTy *Cache = getCache(LineNoCache))
-    if (Cache->LastQueryBufferID == BufferID &&
-        Cache->LastQuery <= Loc.getPointer()) {
-      Ptr = Cache->LastQuery;
-      LineNo = Cache->LineNoOfQuery;
-    }
-
-  // Scan for the location being queried, keeping track of the number of lines
-  // we see.
-  for (; SMLoc::getFromPointer(Ptr) != Loc; ++Ptr)
-    if (*Ptr == '\n') ++LineNo;
+  const char *Ptr = Loc.getPointer();
+  size_t Offset = Ptr - BufStart;
 
   // Allocate the line number cache if it doesn't exist.
   if (LineNoCache == 0)
     LineNoCache = new LineNoCacheTy();
 
-  // Update the line # cache.
+  // The line number is one more than the number of \n's between the start of
+  // the file and the specified location.
   LineNoCacheTy &Cache = *getCache(LineNoCache);
-  Cache.LastQueryBufferID = BufferID;
-  Cache.LastQuery = Ptr;
-  Cache.LineNoOfQuery = LineNo;
-  
+  if (Cache.Buffers.size() <= unsigned(BufferID))
+    Cache.Buffers.resize(BufferID + 1);
+  if (Cache.Buffers[BufferID] == 0)
+    Cache.Buffers[BufferID] = new LineOffsetIndex();
+  LineOffsetIndex &Index = *Cache.Buffers[BufferID];
+  unsigned LineNo;
+  if (Buff->getBufferSize() <= UINT32_MAX)
+    LineNo = getLineNumber(Index.Newlines32, Index.Scanned, BufStart, Offset);
+  else
+    LineNo = getLineNumber(Index.Newlines64, Index.Scanned, BufStart, Offset);
+
   size_t NewlineOffs = StringRef(BufStart, Ptr-BufStart).find_last_of("\n\r");
   if (NewlineOffs == StringRef::npos) NewlineOffs = ~(size_t)0;
   return std::make_pair(LineNo, Ptr-BufStart-NewlineOffs);
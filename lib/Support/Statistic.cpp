@@ -42,6 +42,11 @@ namespace llvm { extern raw_ostream *CreateInfoOutputFile(); }
 static cl::opt<bool>
 Enabled("stats", cl::desc("Enable statistics output from program"));
 
+/// -stats-json - Print the statistics as JSON rather than as a table.
+///
+static cl::opt<bool>
+StatsAsJSON("stats-json", cl::desc("Print statistics output as JSON"));
+
 
 namespace {
 /// StatisticInfo - This class is used in a ManagedStatic so that it is created
@@ -51,6 +56,8 @@ class StatisticInfo {
   std::vector<const Statistic*> Stats;
   friend void llvm::PrintStatistics();
   friend void llvm::PrintStatistics(raw_ostream &OS);
+  friend void llvm::PrintStatisticsJSON(raw_ostream &OS);
+  friend void llvm::GetStatistics(std::vector<const Statistic*> &Stats);
 public:
   ~StatisticInfo();
 
@@ -110,6 +117,7 @@ bool llvm::AreStatisticsEnabled() {
 }
 
 void llvm::PrintStatistics(raw_ostream &OS) {
+  sys::SmartScopedLock<true> Reader(*StatLock);
   StatisticInfo &Stats = *StatInfo;
 
   // Figure out how long the biggest Value and Name fields are.
@@ -141,6 +149,49 @@ void llvm::PrintStatistics(raw_ostream &OS) {
 
 }
 
+/// PrintJSONString - Print Str as a quoted JSON string.
+static void PrintJSONString(raw_ostream &OS, const char *Str) {
+  OS << '"';
+  for (; *Str; ++Str) {
+    unsigned char C = *Str;
+    if (C == '"' || C == '\\')
+      OS << '\\' << C;
+    else if (C < 0x20)
+      OS << format("\\u%04x", C);
+    else
+      OS << C;
+  }
+  OS << '"';
+}
+
+void llvm::PrintStatisticsJSON(raw_ostream &OS) {
+  sys::SmartScopedLock<true> Reader(*StatLock);
+  StatisticInfo &Stats = *StatInfo;
+
+  // Sort the fields by name.
+  std::stable_sort(Stats.Stats.begin(), Stats.Stats.end(), NameCompare());
+
+  OS << "[";
+  for (size_t i = 0, e = Stats.Stats.size(); i != e; ++i) {
+    const Statistic *S = Stats.Stats[i];
+    OS << (i ? ",\n  " : "\n  ") << "{ \"name\": ";
+    PrintJSONString(OS, S->getName());
+    OS << ", \"desc\": ";
+    PrintJSONString(OS, S->getDesc());
+    OS << ", \"value\": " << S->getValue() << " }";
+  }
+  OS << "\n]\n";
+  OS.flush();
+}
+
+void llvm::GetStatistics(std::vector<const Statistic*> &Result) {
+  sys::SmartScopedLock<true> Reader(*StatLock);
+  StatisticInfo &Stats = *StatInfo;
+
+  std::stable_sort(Stats.Stats.begin(), Stats.Stats.end(), NameCompare());
+  Result = Stats.Stats;
+}
+
 void llvm::PrintStatistics() {
   StatisticInfo &Stats = *StatInfo;
 
@@ -149,6 +200,9 @@ void llvm::PrintStatistics() {
 
   // Get the stream to write to.
   raw_ostream &OutStream = *CreateInfoOutputFile();
-  PrintStatistics(OutStream);
+  if (StatsAsJSON)
+    PrintStatisticsJSON(OutStream);
+  else
+    PrintStatistics(OutStream);
   delete &OutStream;   // Close the file.
 }
@@ -22,6 +22,7 @@
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/system_error.h"
 #include "llvm/ADT/STLExtras.h"
+#include <algorithm>
 #include <cctype>
 #include <cerrno>
 #include <sys/stat.h>
@@ -299,14 +300,22 @@ raw_ostream &raw_ostream::write(const char *Ptr, size_t Size) {
 
     size_t NumBytes = OutBufEnd - OutBufCur;
 
-    // If the buffer is empty at this point we have a string that is larger
-    // than the buffer. Directly write the chunk that is a multiple of the
-    // preferred buffer size and put the remainder in the buffer.
-    if (LLVM_UNLIKELY(OutBufCur == OutBufStart)) {
-      size_t BytesToWrite = Size - (Size % NumBytes);
-      write_impl(Ptr, BytesToWrite);
-      copy_to_buffer(Ptr + BytesToWrite, Size - BytesToWrite);
-      return *this;
+    // If the string is at least as large as the whole buffer, copying it
+    // through the buffer would only split it into more writes.  Write what is
+    // buffered together with the string, in as many whole buffers as they
+    // fill, and put the remainder in the buffer.
+    size_t BufferSize = OutBufEnd - OutBufStart;
+    if (LLVM_UNLIKELY(Size >= BufferSize)) {
+      size_t NumBuffered = OutBufCur - OutBufStart;
+      size_t Remainder = (NumBuffered + Size) % BufferSize;
+      size_t BytesToWrite = Size - Remainder;
+      OutBufCur = OutBufStart;
+      if (NumBuffered)
+        writev_impl(OutBufStart, NumBuffered, Ptr, BytesToWrite);
+      else
+        write_impl(Ptr, BytesToWrite);
+      // write_impl may have installed a new buffer, so go through write.
+      return write(Ptr + BytesToWrite, Remainder);
     }
 
     // We don't have enough space in the buffer to fit the string in. Insert as
@@ -321,6 +330,12 @@ raw_ostream &raw_ostream::write(const char *Ptr, size_t Size) {
   return *this;
 }
 
+void raw_ostream::writev_impl(const char *Ptr1, size_t Size1,
+                              const char *Ptr2, size_t Size2) {
+  write_impl(Ptr1, Size1);
+  write_impl(Ptr2, Size2);
+}
+
 void raw_ostream::copy_to_buffer(const char *Ptr, size_t Size) {
   assert(Size <= size_t(OutBufEnd - OutBufCur) && "Buffer overrun!");
 
@@ -565,6 +580,35 @@ void raw_fd_ostream::write_impl(const char *Ptr, size_t Size) {
   } while (Size > 0);
 }
 
+void raw_fd_ostream::writev_impl(const char *Ptr1, size_t Size1,
+                                 const char *Ptr2, size_t Size2) {
+#if defined(HAVE_WRITEV)
+  assert(FD >= 0 && "File already closed.");
+  struct iovec IOV[2] = {
+    { const_cast<char *>(Ptr1), Size1 },
+    { const_cast<char *>(Ptr2), Size2 }
+  };
+  ssize_t ret;
+  do
+    ret = ::writev(FD, IOV, 2);
+  while (ret < 0 && errno == EINTR);
+
+  // Let write_impl deal with errors and retries, as well as with whatever a
+  // short write left over.
+  size_t Written = ret < 0 ? 0 : ret;
+  pos += Written;
+  if (Written < Size1) {
+    write_impl(Ptr1 + Written, Size1 - Written);
+    Written = Size1;
+  }
+  Written -= Size1;
+  if (Written < Size2)
+    write_impl(Ptr2 + Written, Size2 - Written);
+#else
+  raw_ostream::writev_impl(Ptr1, Size1, Ptr2, Size2);
+#endif
+}
+
 void raw_fd_ostream::close() {
   assert(ShouldClose);
   ShouldClose = false;
@@ -598,6 +642,11 @@ size_t raw_fd_ostream::preferred_buffer_size() const {
   // the complexity.
   if (S_ISCHR(statbuf.st_mode) && isatty(FD))
     return 0;
+  // Regular files can be large, e.g. object files with debug info, and a
+  // block-sized buffer makes writing them syscall-bound.  Use a buffer of a
+  // few blocks instead.
+  if (S_ISREG(statbuf.st_mode))
+    return std::max<size_t>(statbuf.st_blksize, 64 * 1024);
   // Return the preferred block size.
   return statbuf.st_blksize;
 #else
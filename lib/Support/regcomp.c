@@ -1489,6 +1489,14 @@ findmust(struct parse *p, struct re_guts *g)
 	}
 	assert(cp == g->must + g->mlen);
 	*cp++ = '\0';		/* just on general principles */
+
+	/* does every match begin with it? */
+	for (scan = g->strip + 1; scan < start; scan++)
+		if (OP(*scan) != OLPAREN && OP(*scan) != ORPAREN &&
+							OP(*scan) != OPLUS_)
+			break;
+	if (scan == start)
+		g->iflags |= MUSTPREFIX;
 }
 
 /*
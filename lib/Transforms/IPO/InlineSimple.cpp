@@ -42,6 +42,12 @@ namespace {
     InlineCost getInlineCost(CallSite CS) {
       return CA.getInlineCost(CS, getInlineThreshold(CS));
     }
+    void resetCachedCostInfo(Function *F) {
+      CA.resetCachedCostInfo(F);
+    }
+    void resetCachedCostData() {
+      CA.clearCachedCostInfo();
+    }
     virtual bool doInitialization(CallGraph &CG);
   };
 }
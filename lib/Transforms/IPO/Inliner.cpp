@@ -351,6 +351,15 @@ bool Inliner::runOnSCC(CallGraphSCC &SCC) {
     DEBUG(dbgs() << " " << (F ? F->getName() : "INDIRECTNODE"));
   }
 
+  // The passes that ran on the previous SCC after us, or on this one if it is
+  // being revisited, may have changed those functions since they were costed.
+  // Functions in earlier SCCs are left alone, so their summaries stay valid.
+  for (unsigned i = 0, e = LastSCCFunctions.size(); i != e; ++i)
+    resetCachedCostInfo(LastSCCFunctions[i]);
+  LastSCCFunctions.assign(SCCFunctions.begin(), SCCFunctions.end());
+  for (unsigned i = 0, e = LastSCCFunctions.size(); i != e; ++i)
+    resetCachedCostInfo(LastSCCFunctions[i]);
+
   // Scan through and identify all call sites ahead of time so that we only
   // inline call sites in the original functions, not call sites that result
   // from inlining other functions.
@@ -389,7 +398,7 @@ bool Inliner::runOnSCC(CallGraphSCC &SCC) {
   // If there are no calls in this function, exit early.
   if (CallSites.empty())
     return false;
-  
+
   // Now that we have all of the call sites, move the ones to functions in the
   // current SCC to the end of the list.
   unsigned FirstCallInSCC = CallSites.size();
@@ -426,6 +435,7 @@ bool Inliner::runOnSCC(CallGraphSCC &SCC) {
         // Update the call graph by deleting the edge from Callee to Caller.
         CG[Caller]->removeCallEdgeFor(CS);
         CS.getInstruction()->eraseFromParent();
+        resetCachedCostInfo(Caller);
         ++NumCallsDeleted;
       } else {
         // We can only inline direct calls to non-declarations.
@@ -451,6 +461,7 @@ bool Inliner::runOnSCC(CallGraphSCC &SCC) {
         if (!InlineCallIfPossible(CS, InlineInfo, InlinedArrayAllocas,
                                   InlineHistoryID, InsertLifetime))
           continue;
+        resetCachedCostInfo(Caller);
         ++NumInlined;
         
         // If inlining this function gave us any new call sites, throw them
@@ -482,6 +493,7 @@ bool Inliner::runOnSCC(CallGraphSCC &SCC) {
         DEBUG(dbgs() << "    -> Deleting dead function: "
               << Callee->getName() << "\n");
         CallGraphNode *CalleeNode = CG[Callee];
+        resetCachedCostInfo(Callee);
         
         // Remove any call graph edges from the callee to its callees.
         CalleeNode->removeAllCalledFunctions();
@@ -514,6 +526,8 @@ bool Inliner::runOnSCC(CallGraphSCC &SCC) {
 // doFinalization - Remove now-dead linkonce functions at the end of
 // processing to avoid breaking the SCC traversal.
 bool Inliner::doFinalization(CallGraph &CG) {
+  LastSCCFunctions.clear();
+  resetCachedCostData();
   return removeDeadFunctions(CG);
 }
 
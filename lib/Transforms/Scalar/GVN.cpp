@@ -60,6 +60,12 @@ static cl::opt<bool> EnablePRE("enable-pre",
                                cl::init(true), cl::Hidden);
 static cl::opt<bool> EnableLoadPRE("enable-load-pre", cl::init(true));
 
+// Maximum number of loop-entering predecessors a load may be PRE'd into.
+static cl::opt<unsigned>
+MaxLoopLoadPREPreds("max-loop-load-pre-preds", cl::Hidden, cl::init(4),
+  cl::desc("Max number of loop entry blocks to insert a PRE'd load into "
+           "(default = 4)"));
+
 // Maximum allowed recursion depth.
 static cl::opt<uint32_t>
 MaxRecurseDepth("max-recurse-depth", cl::Hidden, cl::init(1000), cl::ZeroOrMore,
@@ -604,6 +610,8 @@ namespace {
     bool processLoad(LoadInst *L);
     bool processInstruction(Instruction *I);
     bool processNonLocalLoad(LoadInst *L);
+    bool isLoopEntryPRE(BasicBlock *LoadBB,
+                        const DenseMap<BasicBlock*, Value*> &PredLoads);
     bool processBlock(BasicBlock *BB);
     void dump(DenseMap<uint32_t, Value*> &d);
     bool iterateOnFunction(Function &F);
@@ -1328,6 +1336,25 @@ static bool isLifetimeStart(const Instruction *Inst) {
   return false;
 }
 
+/// isLoopEntryPRE - Return true if LoadBB is the header of a loop and all of
+/// the predecessors in PredLoads enter the loop from outside of it, i.e. none
+/// of them is reached from LoadBB through a backedge.
+bool GVN::isLoopEntryPRE(BasicBlock *LoadBB,
+                         const DenseMap<BasicBlock*, Value*> &PredLoads) {
+  bool HasBackedge = false;
+  for (pred_iterator PI = pred_begin(LoadBB), E = pred_end(LoadBB);
+       PI != E; ++PI) {
+    if (!DT->dominates(LoadBB, *PI))
+      continue;
+    // A backedge along which the value is not available means we would have
+    // to insert the load inside the loop.
+    if (PredLoads.count(*PI))
+      return false;
+    HasBackedge = true;
+  }
+  return HasBackedge;
+}
+
 /// processNonLocalLoad - Attempt to eliminate a load whose dependencies are
 /// non-local by performing PHI construction.
 bool GVN::processNonLocalLoad(LoadInst *LI) {
@@ -1616,11 +1643,17 @@ bool GVN::processNonLocalLoad(LoadInst *LI) {
   assert(NumUnavailablePreds != 0 &&
          "Fully available value should be eliminated above!");
 
-  // If this load is unavailable in multiple predecessors, reject it.
+  // If this load is unavailable in multiple predecessors, reject it.  The one
+  // exception is a load in a loop header which is available along every
+  // backedge: inserting a load into each block that enters the loop moves the
+  // load out of the loop rather than duplicating it on a hot path, so we allow
+  // it as long as the number of new loads stays small.
   // FIXME: If we could restructure the CFG, we could make a common pred with
   // all the preds that don't have an available LI and insert a new load into
   // that one block.
-  if (NumUnavailablePreds != 1)
+  if (NumUnavailablePreds != 1 &&
+      (NumUnavailablePreds > MaxLoopLoadPREPreds ||
+       !isLoopEntryPRE(LoadBB, PredLoads)))
       return false;
 
   // Check if the load can safely be moved to all the unavailable predecessors.
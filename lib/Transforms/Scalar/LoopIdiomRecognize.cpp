@@ -16,15 +16,17 @@
 // TODO List:
 //
 // Future loop memory idioms to recognize:
-//   memcmp, memmove, strlen, etc.
+//   memchr, memcmp, memmove, strlen, etc.
 // Future floating point idioms to recognize in -ffast-math mode:
 //   fpowi
 // Future integer operation idioms to recognize:
-//   ctpop, ctlz, cttz
+//   ctlz, cttz
 //
 // Beware that isel's default lowering for ctpop is highly inefficient for
 // i64 and larger types when i64 is legal and the value has few bits set.  It
-// would be good to enhance isel to emit a loop for ctpop in this case.
+// would be good to enhance isel to emit a loop for ctpop in this case.  Until
+// this pass can ask the target whether ctpop is cheap, the popcount idiom is
+// only recognized under -loop-idiom-ctpop.
 //
 // We should enhance the memset/memcpy recognition to handle multiple stores in
 // the loop.  This would handle things like:
@@ -52,15 +54,24 @@
 #include "llvm/Analysis/ScalarEvolutionExpander.h"
 #include "llvm/Analysis/ScalarEvolutionExpressions.h"
 #include "llvm/Analysis/ValueTracking.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/PatternMatch.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetData.h"
 #include "llvm/Target/TargetLibraryInfo.h"
 #include "llvm/Transforms/Utils/Local.h"
 using namespace llvm;
+using namespace llvm::PatternMatch;
 
 STATISTIC(NumMemSet, "Number of memset's formed from loop stores");
 STATISTIC(NumMemCpy, "Number of memcpy's formed from loop load+stores");
+STATISTIC(NumPopCount, "Number of popcount loops rewritten to use ctpop");
+
+static cl::opt<bool>
+EnableCtpopIdiom("loop-idiom-ctpop", cl::Hidden, cl::init(false),
+                 cl::desc("Recognize loops which count set bits and rewrite "
+                          "them in terms of llvm.ctpop"));
 
 namespace {
   class LoopIdiomRecognize : public LoopPass {
@@ -92,6 +103,8 @@ namespace {
                                     const SCEVAddRecExpr *LoadEv,
                                     const SCEV *BECount);
 
+    bool recognizePopcount();
+
     /// This transformation requires natural loop information & requires that
     /// loop preheaders be inserted into the CFG.
     ///
@@ -185,10 +198,11 @@ bool LoopIdiomRecognize::runOnLoop(Loop *L, LPPassManager &LPM) {
   if (Name == "memset" || Name == "memcpy")
     return false;
 
-  // The trip count of the loop must be analyzable.
+  // The trip count of the loop must be analyzable, unless this is one of the
+  // idioms which compute something from a data-dependent trip count.
   SE = &getAnalysis<ScalarEvolution>();
   if (!SE->hasLoopInvariantBackedgeTakenCount(L))
-    return false;
+    return recognizePopcount();
   const SCEV *BECount = SE->getBackedgeTakenCount(L);
   if (isa<SCEVCouldNotCompute>(BECount)) return false;
 
@@ -639,3 +653,170 @@ processLoopStoreOfLoopLoad(StoreInst *SI, unsigned StoreSize,
   ++NumMemCpy;
   return true;
 }
+
+/// isPopcountGuarded - Return true if the preheader of the loop is only
+/// reached when Val is non-zero, i.e. its predecessor branches on Val != 0.
+static bool isPopcountGuarded(Value *Val, BasicBlock *Preheader) {
+  BasicBlock *PreCondBB = Preheader->getSinglePredecessor();
+  if (!PreCondBB)
+    return false;
+  BranchInst *BI = dyn_cast<BranchInst>(PreCondBB->getTerminator());
+  if (!BI || !BI->isConditional())
+    return false;
+  ICmpInst *Cond = dyn_cast<ICmpInst>(BI->getCondition());
+  if (!Cond || !Cond->isEquality() || Cond->getOperand(0) != Val ||
+      !match(Cond->getOperand(1), m_Zero()))
+    return false;
+  unsigned NonZeroSucc = Cond->getPredicate() == ICmpInst::ICMP_NE ? 0 : 1;
+  return BI->getSuccessor(NonZeroSucc) == Preheader &&
+         BI->getSuccessor(1 - NonZeroSucc) != Preheader;
+}
+
+/// recognizePopcount - Look for a loop which counts the set bits in a value by
+/// repeatedly clearing the lowest one:
+///
+///   loop:
+///     %cnt = phi [ %cnt0, %preheader ], [ %cnt.next, %loop ]
+///     %x = phi [ %x0, %preheader ], [ %x.next, %loop ]
+///     %dec = add %x, -1
+///     %x.next = and %x, %dec
+///     %cnt.next = add %cnt, 1
+///     %tobool = icmp ne %x.next, 0
+///     br i1 %tobool, label %loop, label %exit
+///
+/// The count on exit is %cnt0 + ctpop(%x0) (the loop runs once for %x0 == 0).
+/// Uses of it after the loop are rewritten to that, and the loop is changed to
+/// count down from the trip count so that it has a computable trip count and
+/// can be deleted by later passes.
+bool LoopIdiomRecognize::recognizePopcount() {
+  if (!EnableCtpopIdiom)
+    return false;
+  TLI = &getAnalysis<TargetLibraryInfo>();
+
+  // Only handle the canonical single-block form.
+  if (CurLoop->getNumBlocks() != 1)
+    return false;
+  BasicBlock *LoopBB = CurLoop->getHeader();
+  BasicBlock *Preheader = CurLoop->getLoopPreheader();
+
+  BranchInst *Br = dyn_cast<BranchInst>(LoopBB->getTerminator());
+  if (!Br || !Br->isConditional())
+    return false;
+  ICmpInst *Cmp = dyn_cast<ICmpInst>(Br->getCondition());
+  if (!Cmp || !Cmp->hasOneUse() || !Cmp->isEquality() ||
+      !match(Cmp->getOperand(1), m_Zero()))
+    return false;
+  // The loop must keep running while the value is non-zero.
+  bool LoopOnTrue = Br->getSuccessor(0) == LoopBB;
+  if ((Cmp->getPredicate() == ICmpInst::ICMP_NE) != LoopOnTrue)
+    return false;
+
+  // Match %x.next = and %x, (add %x, -1).
+  BinaryOperator *XNext = dyn_cast<BinaryOperator>(Cmp->getOperand(0));
+  if (!XNext || XNext->getOpcode() != Instruction::And ||
+      XNext->getParent() != LoopBB)
+    return false;
+  PHINode *XPhi = 0;
+  Instruction *XDec = 0;
+  for (unsigned i = 0; i != 2 && !XPhi; ++i) {
+    PHINode *PN = dyn_cast<PHINode>(XNext->getOperand(i));
+    Instruction *Dec = dyn_cast<Instruction>(XNext->getOperand(1 - i));
+    if (PN && Dec && match(Dec, m_Add(m_Specific(PN), m_AllOnes()))) {
+      XPhi = PN;
+      XDec = Dec;
+    }
+  }
+  if (!XPhi || XPhi->getParent() != LoopBB ||
+      XPhi->getIncomingValueForBlock(LoopBB) != XNext)
+    return false;
+  Value *XInit = XPhi->getIncomingValueForBlock(Preheader);
+
+  // Find the counter: a phi incremented by one on every iteration.
+  PHINode *CntPhi = 0;
+  Instruction *CntNext = 0;
+  for (BasicBlock::iterator I = LoopBB->begin(); isa<PHINode>(I); ++I) {
+    PHINode *PN = cast<PHINode>(I);
+    if (PN == XPhi)
+      continue;
+    Instruction *Inc =
+      dyn_cast<Instruction>(PN->getIncomingValueForBlock(LoopBB));
+    if (CntPhi || !Inc || !match(Inc, m_Add(m_Specific(PN), m_One())))
+      return false;
+    CntPhi = PN;
+    CntNext = Inc;
+  }
+  if (!CntPhi || !CntPhi->getType()->isIntegerTy())
+    return false;
+
+  // Nothing else may happen in the loop, and only the final count and value
+  // may be used after it.
+  if (LoopBB->size() != 7)
+    return false;
+  Instruction *LoopInsts[] = { XPhi, CntPhi, XDec, XNext, CntNext, Cmp, Br };
+  for (unsigned i = 0; i != array_lengthof(LoopInsts); ++i) {
+    if (LoopInsts[i]->getParent() != LoopBB)
+      return false;
+    if (LoopInsts[i] == XNext || LoopInsts[i] == CntNext)
+      continue;
+    for (Value::use_iterator UI = LoopInsts[i]->use_begin(),
+         UE = LoopInsts[i]->use_end(); UI != UE; ++UI)
+      if (!CurLoop->contains(cast<Instruction>(*UI)))
+        return false;
+  }
+
+  DEBUG(dbgs() << "loop-idiom: Formed ctpop for loop %"
+               << LoopBB->getName() << "\n");
+
+  SE->forgetLoop(CurLoop);
+
+  // Compute the trip count in the preheader: ctpop(%x0), or one if %x0 may
+  // be zero on entry.
+  IntegerType *XTy = cast<IntegerType>(XInit->getType());
+  IRBuilder<> Builder(Preheader->getTerminator());
+  Module *M = LoopBB->getParent()->getParent();
+  Value *PopCnt = Builder.CreateCall(Intrinsic::getDeclaration(M,
+                                                               Intrinsic::ctpop,
+                                                               XTy),
+                                     XInit, "popcnt");
+  Value *TripCnt = PopCnt;
+  if (!isPopcountGuarded(XInit, Preheader))
+    TripCnt = Builder.CreateSelect(Builder.CreateIsNull(XInit),
+                                   ConstantInt::get(XTy, 1), PopCnt,
+                                   "popcnt.trip");
+  Value *CntInit = CntPhi->getIncomingValueForBlock(Preheader);
+  Value *FinalCnt =
+    Builder.CreateAdd(CntInit,
+                      Builder.CreateZExtOrTrunc(TripCnt,
+                                            cast<IntegerType>(CntPhi->getType())),
+                      "popcnt.final");
+
+  // Rewrite the users outside the loop.
+  SmallVector<Use*, 8> OutsideUses;
+  for (Value::use_iterator UI = CntNext->use_begin(), UE = CntNext->use_end();
+       UI != UE; ++UI)
+    if (!CurLoop->contains(cast<Instruction>(*UI)))
+      OutsideUses.push_back(&UI.getUse());
+  for (unsigned i = 0, e = OutsideUses.size(); i != e; ++i)
+    OutsideUses[i]->set(FinalCnt);
+  OutsideUses.clear();
+  for (Value::use_iterator UI = XNext->use_begin(), UE = XNext->use_end();
+       UI != UE; ++UI)
+    if (!CurLoop->contains(cast<Instruction>(*UI)))
+      OutsideUses.push_back(&UI.getUse());
+  for (unsigned i = 0, e = OutsideUses.size(); i != e; ++i)
+    OutsideUses[i]->set(Constant::getNullValue(XTy));
+
+  // Make the loop count down from the trip count instead.
+  PHINode *TcPhi = PHINode::Create(XTy, 2, "tcphi", LoopBB->begin());
+  Builder.SetInsertPoint(Br);
+  Value *TcDec = Builder.CreateSub(TcPhi, ConstantInt::get(XTy, 1), "tcdec");
+  Value *NewCond = LoopOnTrue ? Builder.CreateIsNotNull(TcDec) :
+                                Builder.CreateIsNull(TcDec);
+  TcPhi->addIncoming(TripCnt, Preheader);
+  TcPhi->addIncoming(TcDec, LoopBB);
+  Br->setCondition(NewCond);
+  deleteDeadInstruction(Cmp, *SE, TLI);
+
+  ++NumPopCount;
+  return true;
+}
@@ -521,7 +521,7 @@ public:
   TypePrinting() {}
   ~TypePrinting() {}
 
-  void incorporateTypes(const Module &M);
+  void incorporateTypes(const Module &M, bool MaterializeFunctions = false);
 
   void print(Type *Ty, raw_ostream &OS);
 
@@ -532,9 +532,44 @@ public:
 } // end anonymous namespace.
 
 
-void TypePrinting::incorporateTypes(const Module &M) {
+/// materializeForPrinting - Read in the body of F if it is being loaded
+/// lazily.  Returns true if a body was read in which the caller should release
+/// again with dematerializeAfterPrinting.
+static bool materializeForPrinting(const Function *F, std::string *ErrInfo) {
+  if (!F->isMaterializable())
+    return false;
+  return !const_cast<Function*>(F)->Materialize(ErrInfo);
+}
+
+/// dematerializeAfterPrinting - Drop the body read in by
+/// materializeForPrinting.  Dematerializing resets the linkage, so restore it
+/// to leave the module as it was found.  Bodies with address-taken blocks are
+/// kept: deleting them would destroy the blockaddress constants that refer to
+/// their blocks from elsewhere in the module.
+static void dematerializeAfterPrinting(const Function *F) {
+  for (Function::const_iterator BB = F->begin(), E = F->end(); BB != E; ++BB)
+    if (BB->hasAddressTaken())
+      return;
+
+  Function *MF = const_cast<Function*>(F);
+  GlobalValue::LinkageTypes Linkage = MF->getLinkage();
+  MF->Dematerialize();
+  MF->setLinkage(Linkage);
+}
+
+void TypePrinting::incorporateTypes(const Module &M,
+                                    bool MaterializeFunctions) {
   NamedTypes.run(M, false);
 
+  // The bodies of lazily loaded functions are invisible to run(), so read them
+  // in one at a time to find the types they use.
+  if (MaterializeFunctions)
+    for (Module::const_iterator I = M.begin(), E = M.end(); I != E; ++I)
+      if (materializeForPrinting(I, 0)) {
+        NamedTypes.incorporateFunction(*I);
+        dematerializeAfterPrinting(I);
+      }
+
   // The list of struct types we got back includes all the struct types, split
   // the unnamed ones out to a numbering and remove the anonymous structs.
   unsigned NextNumber = 0;
@@ -1232,16 +1267,25 @@ class AssemblyWriter {
   TypePrinting TypePrinter;
   AssemblyAnnotationWriter *AnnotationWriter;
 
+  /// MaterializeFunctions - Read in lazily loaded function bodies just before
+  /// they are printed and drop them again afterwards.
+  bool MaterializeFunctions;
+
 public:
+  /// MaterializeError - The first error hit while reading in a function body.
+  std::string MaterializeError;
+
   inline AssemblyWriter(formatted_raw_ostream &o, SlotTracker &Mac,
                         const Module *M,
-                        AssemblyAnnotationWriter *AAW)
-    : Out(o), Machine(Mac), TheModule(M), AnnotationWriter(AAW) {
+                        AssemblyAnnotationWriter *AAW,
+                        bool materializeFunctions = false)
+    : Out(o), Machine(Mac), TheModule(M), AnnotationWriter(AAW),
+      MaterializeFunctions(materializeFunctions) {
     TypePrinter.TheModule = const_cast<Module *>(M);
     TypePrinter.Machine = &Machine;
 
     if (M)
-      TypePrinter.incorporateTypes(*M);
+      TypePrinter.incorporateTypes(*M, MaterializeFunctions);
   }
 
   void printMDNodeBody(const MDNode *MD);
@@ -1601,6 +1645,14 @@ void AssemblyWriter::printTypeIdentities() {
 /// printFunction - Print all aspects of a function.
 ///
 void AssemblyWriter::printFunction(const Function *F) {
+  bool Materialized = false;
+  if (MaterializeFunctions) {
+    std::string ErrInfo;
+    Materialized = materializeForPrinting(F, &ErrInfo);
+    if (!ErrInfo.empty() && MaterializeError.empty())
+      MaterializeError = ErrInfo;
+  }
+
   // Print out the return type and name.
   Out << '\n';
 
@@ -1694,6 +1746,9 @@ void AssemblyWriter::printFunction(const Function *F) {
   }
 
   Machine.purgeFunction();
+
+  if (Materialized)
+    dematerializeAfterPrinting(F);
 }
 
 /// printArgument - This member is called for every argument that is passed into
@@ -2145,6 +2200,20 @@ void Module::print(raw_ostream &ROS, AssemblyAnnotationWriter *AAW) const {
   W.printModule(this);
 }
 
+bool llvm::WriteModuleLazily(raw_ostream &ROS, Module *M,
+                             AssemblyAnnotationWriter *AAW,
+                             std::string *ErrInfo) {
+  SlotTracker SlotTable(M);
+  formatted_raw_ostream OS(ROS);
+  AssemblyWriter W(OS, SlotTable, M, AAW, /*materializeFunctions=*/true);
+  W.printModule(M);
+  if (W.MaterializeError.empty())
+    return false;
+  if (ErrInfo)
+    *ErrInfo = W.MaterializeError;
+  return true;
+}
+
 void NamedMDNode::print(raw_ostream &ROS, AssemblyAnnotationWriter *AAW) const {
   SlotTracker SlotTable(getParent());
   formatted_raw_ostream OS(ROS);
@@ -28,10 +28,12 @@ MDNode *DebugLoc::getScope(const LLVMContext &Ctx) const {
     return Ctx.pImpl->ScopeRecords[ScopeIdx-1].get();
   }
   
-  // Otherwise, the index is in the ScopeInlinedAtRecords array.
+  // Otherwise, the index is in the ScopeInlinedAtRecords array, which refers
+  // back to ScopeRecords for the scope.
   assert(unsigned(-ScopeIdx) <= Ctx.pImpl->ScopeInlinedAtRecords.size() &&
          "Invalid ScopeIdx");
-  return Ctx.pImpl->ScopeInlinedAtRecords[-ScopeIdx-1].first.get();
+  int Idx = Ctx.pImpl->ScopeInlinedAtRecords[-ScopeIdx-1].first;
+  return Ctx.pImpl->ScopeRecords[Idx-1].get();
 }
 
 MDNode *DebugLoc::getInlinedAt(const LLVMContext &Ctx) const {
@@ -66,8 +68,10 @@ void DebugLoc::getScopeAndInlinedAt(MDNode *&Scope, MDNode *&IA,
   // Otherwise, the index is in the ScopeInlinedAtRecords array.
   assert(unsigned(-ScopeIdx) <= Ctx.pImpl->ScopeInlinedAtRecords.size() &&
          "Invalid ScopeIdx");
-  Scope = Ctx.pImpl->ScopeInlinedAtRecords[-ScopeIdx-1].first.get();
-  IA    = Ctx.pImpl->ScopeInlinedAtRecords[-ScopeIdx-1].second.get();
+  const std::pair<int, DebugRecVH> &Entry =
+    Ctx.pImpl->ScopeInlinedAtRecords[-ScopeIdx-1];
+  Scope = Ctx.pImpl->ScopeRecords[Entry.first-1].get();
+  IA    = Entry.second.get();
 }
 
 
@@ -86,10 +90,11 @@ DebugLoc DebugLoc::get(unsigned Line, unsigned Col,
   LLVMContext &Ctx = Scope->getContext();
   
   // If there is no inlined-at location, use the ScopeRecords array.
-  if (InlinedAt == 0)
-    Result.ScopeIdx = Ctx.pImpl->getOrAddScopeRecordIdxEntry(Scope, 0);
-  else
-    Result.ScopeIdx = Ctx.pImpl->getOrAddScopeInlinedAtIdxEntry(Scope,
+  // Otherwise the scope still gets a ScopeRecords entry, which is shared by
+  // every inlined-at record for it.
+  Result.ScopeIdx = Ctx.pImpl->getOrAddScopeRecordIdxEntry(Scope, 0);
+  if (InlinedAt)
+    Result.ScopeIdx = Ctx.pImpl->getOrAddScopeInlinedAtIdxEntry(Result.ScopeIdx,
                                                                 InlinedAt, 0);
 
   return Result;
@@ -181,10 +186,12 @@ int LLVMContextImpl::getOrAddScopeRecordIdxEntry(MDNode *Scope,
   return Idx;
 }
 
-int LLVMContextImpl::getOrAddScopeInlinedAtIdxEntry(MDNode *Scope, MDNode *IA,
+int LLVMContextImpl::getOrAddScopeInlinedAtIdxEntry(int ScopeIdx, MDNode *IA,
                                                     int ExistingIdx) {
+  assert(ScopeIdx > 0 && "Inlined-at entries refer to a ScopeRecords entry");
+
   // If we already have an entry, return it.
-  int &Idx = ScopeInlinedAtIdx[std::make_pair(Scope, IA)];
+  int &Idx = ScopeInlinedAtIdx[std::make_pair(ScopeIdx, IA)];
   if (Idx) return Idx;
   
   // If we don't have an entry, but ExistingIdx is specified, use it.
@@ -198,7 +205,7 @@ int LLVMContextImpl::getOrAddScopeInlinedAtIdxEntry(MDNode *Scope, MDNode *IA,
     
   // Index is biased by 1 and negated.
   Idx = -ScopeInlinedAtRecords.size()-1;
-  ScopeInlinedAtRecords.push_back(std::make_pair(DebugRecVH(Scope, this, Idx),
+  ScopeInlinedAtRecords.push_back(std::make_pair(ScopeIdx,
                                                  DebugRecVH(IA, this, Idx)));
   return Idx;
 }
@@ -230,27 +237,22 @@ void DebugRecVH::deleted() {
     return;
   }
   
-  // Otherwise, it is an entry in ScopeInlinedAtRecords, we don't know if it
-  // is the scope or the inlined-at record entry.
+  // Otherwise, it is the inlined-at half of an entry in
+  // ScopeInlinedAtRecords.  The scope half is an index into ScopeRecords,
+  // whose own value handle tracks the scope.
   assert(unsigned(-Idx-1) < Ctx->ScopeInlinedAtRecords.size());
-  std::pair<DebugRecVH, DebugRecVH> &Entry = Ctx->ScopeInlinedAtRecords[-Idx-1];
-  assert((this == &Entry.first || this == &Entry.second) &&
-         "Mapping out of date!");
+  std::pair<int, DebugRecVH> &Entry = Ctx->ScopeInlinedAtRecords[-Idx-1];
+  assert(this == &Entry.second && "Mapping out of date!");
   
-  MDNode *OldScope = Entry.first.get();
-  MDNode *OldInlinedAt = Entry.second.get();
-  assert(OldScope != 0 && OldInlinedAt != 0 &&
-         "Entry should be non-canonical if either val dropped to null");
-
-  // Otherwise, we do have an entry in it, nuke it and we're done.
-  assert(Ctx->ScopeInlinedAtIdx[std::make_pair(OldScope, OldInlinedAt)] == Idx&&
-         "Mapping out of date");
-  Ctx->ScopeInlinedAtIdx.erase(std::make_pair(OldScope, OldInlinedAt));
+  // We do have an entry in the map, nuke it and we're done.
+  std::pair<int, MDNode*> Key(Entry.first, Cur);
+  assert(Ctx->ScopeInlinedAtIdx[Key] == Idx && "Mapping out of date");
+  Ctx->ScopeInlinedAtIdx.erase(Key);
   
-  // Reset this VH to null.  Drop both 'Idx' values to null to indicate that
-  // we're in non-canonical form now.
+  // Reset this VH to null.  Drop 'Idx' to null to indicate that we're in
+  // non-canonical form now.
   setValPtr(0);
-  Entry.first.Idx = Entry.second.Idx = 0;
+  Idx = 0;
 }
 
 void DebugRecVH::allUsesReplacedWith(Value *NewVa) {
@@ -284,32 +286,25 @@ void DebugRecVH::allUsesReplacedWith(Value *NewVa) {
     return;
   }
   
-  // Otherwise, it is an entry in ScopeInlinedAtRecords, we don't know if it
-  // is the scope or the inlined-at record entry.
+  // Otherwise, it is the inlined-at half of an entry in
+  // ScopeInlinedAtRecords.  A RAUW of the scope is handled by the scope's
+  // ScopeRecords handle.
   assert(unsigned(-Idx-1) < Ctx->ScopeInlinedAtRecords.size());
-  std::pair<DebugRecVH, DebugRecVH> &Entry = Ctx->ScopeInlinedAtRecords[-Idx-1];
-  assert((this == &Entry.first || this == &Entry.second) &&
-         "Mapping out of date!");
+  std::pair<int, DebugRecVH> &Entry = Ctx->ScopeInlinedAtRecords[-Idx-1];
+  assert(this == &Entry.second && "Mapping out of date!");
   
-  MDNode *OldScope = Entry.first.get();
-  MDNode *OldInlinedAt = Entry.second.get();
-  assert(OldScope != 0 && OldInlinedAt != 0 &&
-         "Entry should be non-canonical if either val dropped to null");
-  
-  // Otherwise, we do have an entry in it, nuke it and we're done.
-  assert(Ctx->ScopeInlinedAtIdx[std::make_pair(OldScope, OldInlinedAt)] == Idx&&
-         "Mapping out of date");
-  Ctx->ScopeInlinedAtIdx.erase(std::make_pair(OldScope, OldInlinedAt));
+  // We do have an entry in the map, nuke it.
+  std::pair<int, MDNode*> Key(Entry.first, OldVal);
+  assert(Ctx->ScopeInlinedAtIdx[Key] == Idx && "Mapping out of date");
+  Ctx->ScopeInlinedAtIdx.erase(Key);
   
   // Reset this VH to the new value.
   setValPtr(NewVal);
 
-  int NewIdx = Ctx->getOrAddScopeInlinedAtIdxEntry(Entry.first.get(),
-                                                   Entry.second.get(), Idx);
+  int ScopeIdx = Entry.first;
+  int NewIdx = Ctx->getOrAddScopeInlinedAtIdxEntry(ScopeIdx, NewVal, Idx);
   // If NewVal already has an entry, this becomes a non-canonical reference,
   // just drop Idx to 0 to signify this.
-  if (NewIdx != Idx) {
-    std::pair<DebugRecVH, DebugRecVH> &Entry=Ctx->ScopeInlinedAtRecords[-Idx-1];
-    Entry.first.Idx = Entry.second.Idx = 0;
-  }
+  if (NewIdx != Idx)
+    Idx = 0;
 }
@@ -160,3 +160,15 @@ void LLVMContext::getMDKindNames(SmallVectorImpl<StringRef> &Names) const {
        E = pImpl->CustomMDKindNames.end(); I != E; ++I)
     Names[I->second] = I->first();
 }
+
+//===----------------------------------------------------------------------===//
+// Memory Accounting
+//===----------------------------------------------------------------------===//
+
+void LLVMContext::getMemoryUsage(MemoryUsage &Usage) const {
+  pImpl->getMemoryUsage(Usage);
+}
+
+unsigned LLVMContext::removeDeadConstantsAndMetadata() {
+  return pImpl->removeDeadConstantsAndMetadata();
+}
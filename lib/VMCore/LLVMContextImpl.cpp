@@ -118,6 +118,189 @@ LLVMContextImpl::~LLVMContextImpl() {
   DeleteContainerSeconds(MDStringCache);
 }
 
+namespace {
+// Appends 'second' of each entry of a uniquing map, which is a Constant*.
+struct CollectSecond {
+  SmallVectorImpl<Constant*> &Constants;
+  explicit CollectSecond(SmallVectorImpl<Constant*> &C) : Constants(C) {}
+  template<typename PairT>
+  void operator()(const PairT &P) {
+    Constants.push_back(P.second);
+  }
+};
+
+// Appends 'first' of each entry of a ConstantAggrUniqueMap.
+struct CollectFirst {
+  SmallVectorImpl<Constant*> &Constants;
+  explicit CollectFirst(SmallVectorImpl<Constant*> &C) : Constants(C) {}
+  template<typename PairT>
+  void operator()(const PairT &P) {
+    Constants.push_back(P.first);
+  }
+};
+}
+
+void LLVMContextImpl::getAllConstants(SmallVectorImpl<Constant*> &Constants) {
+  std::for_each(IntConstants.begin(), IntConstants.end(),
+                CollectSecond(Constants));
+  std::for_each(FPConstants.begin(), FPConstants.end(),
+                CollectSecond(Constants));
+  std::for_each(CAZConstants.begin(), CAZConstants.end(),
+                CollectSecond(Constants));
+  std::for_each(CPNConstants.begin(), CPNConstants.end(),
+                CollectSecond(Constants));
+  std::for_each(UVConstants.begin(), UVConstants.end(),
+                CollectSecond(Constants));
+  std::for_each(BlockAddresses.begin(), BlockAddresses.end(),
+                CollectSecond(Constants));
+  std::for_each(ExprConstants.map_begin(), ExprConstants.map_end(),
+                CollectSecond(Constants));
+  std::for_each(ArrayConstants.map_begin(), ArrayConstants.map_end(),
+                CollectFirst(Constants));
+  std::for_each(StructConstants.map_begin(), StructConstants.map_end(),
+                CollectFirst(Constants));
+  std::for_each(VectorConstants.map_begin(), VectorConstants.map_end(),
+                CollectFirst(Constants));
+
+  // Constants with the same raw data but different types share a map entry
+  // and are chained off it.
+  for (StringMap<ConstantDataSequential*>::iterator I = CDSConstants.begin(),
+       E = CDSConstants.end(); I != E; ++I)
+    for (ConstantDataSequential *CDS = I->second; CDS; CDS = CDS->Next)
+      Constants.push_back(CDS);
+}
+
+unsigned LLVMContextImpl::removeDeadConstantsAndMetadata() {
+  unsigned NumRemoved = 0;
+  bool Changed;
+  do {
+    Changed = false;
+
+    // Destroying a constant drops the uses of its operands, which may make
+    // other constants dead; those are picked up on the next iteration.
+    SmallVector<Constant*, 64> Constants;
+    getAllConstants(Constants);
+    for (SmallVectorImpl<Constant*>::iterator I = Constants.begin(),
+           E = Constants.end(); I != E; ++I) {
+      Constant *C = *I;
+      if (!C->use_empty() || C->hasValueHandle() ||
+          C == TheTrueVal || C == TheFalseVal)
+        continue;
+
+      // ConstantInt and ConstantFP are never destroyed through
+      // destroyConstant, so unmap them by hand.
+      if (ConstantInt *CI = dyn_cast<ConstantInt>(C)) {
+        IntConstants.erase(DenseMapAPIntKeyInfo::KeyTy(CI->getValue(),
+                                                       CI->getType()));
+        delete CI;
+      } else if (ConstantFP *CFP = dyn_cast<ConstantFP>(C)) {
+        FPConstants.erase(DenseMapAPFloatKeyInfo::KeyTy(CFP->getValueAPF()));
+        delete CFP;
+      } else {
+        C->destroyConstant();
+      }
+      ++NumRemoved;
+      Changed = true;
+    }
+
+    // ~MDNode can move nodes between the MDNodeSet and NonUniquedMDNodes, so
+    // copy them out first.  A node with no uses and no value handles is not
+    // an operand of any other node, so destroying one never frees another.
+    SmallVector<MDNode*, 64> MDNodes;
+    for (FoldingSetIterator<MDNode> I = MDNodeSet.begin(), E = MDNodeSet.end();
+         I != E; ++I)
+      MDNodes.push_back(&*I);
+    MDNodes.append(NonUniquedMDNodes.begin(), NonUniquedMDNodes.end());
+    for (SmallVectorImpl<MDNode*>::iterator I = MDNodes.begin(),
+           E = MDNodes.end(); I != E; ++I) {
+      MDNode *N = *I;
+      if (!N->use_empty() || N->hasValueHandle())
+        continue;
+      N->destroy();
+      ++NumRemoved;
+      Changed = true;
+    }
+
+    for (StringMap<Value*>::iterator I = MDStringCache.begin(),
+           E = MDStringCache.end(); I != E; ) {
+      StringMap<Value*>::iterator Cur = I;
+      ++I;
+      Value *S = Cur->second;
+      if (!S->use_empty() || S->hasValueHandle())
+        continue;
+      delete S;
+      MDStringCache.erase(Cur);
+      ++NumRemoved;
+      Changed = true;
+    }
+  } while (Changed);
+
+  return NumRemoved;
+}
+
+void LLVMContextImpl::getMemoryUsage(LLVMContext::MemoryUsage &Usage) {
+  SmallVector<Constant*, 64> Constants;
+  getAllConstants(Constants);
+  Usage.NumConstants = Constants.size();
+  Usage.ConstantBytes = IntConstants.getMemorySize() +
+                        FPConstants.getMemorySize() +
+                        CAZConstants.getMemorySize() +
+                        CPNConstants.getMemorySize() +
+                        UVConstants.getMemorySize() +
+                        BlockAddresses.getMemorySize();
+  for (SmallVectorImpl<Constant*>::iterator I = Constants.begin(),
+         E = Constants.end(); I != E; ++I) {
+    Constant *C = *I;
+    size_t Bytes = C->getNumOperands() * sizeof(Use);
+    if (ConstantInt *CI = dyn_cast<ConstantInt>(C))
+      Bytes += sizeof(ConstantInt) +
+               (CI->getBitWidth() <= 64 ? 0 :
+                CI->getValue().getNumWords() * sizeof(uint64_t));
+    else if (isa<ConstantFP>(C))
+      Bytes += sizeof(ConstantFP);
+    else if (ConstantDataSequential *CDS = dyn_cast<ConstantDataSequential>(C))
+      Bytes += sizeof(ConstantDataSequential) +
+               CDS->getRawDataValues().size();
+    else if (isa<ConstantExpr>(C))
+      Bytes += sizeof(ConstantExpr);
+    else
+      Bytes += sizeof(Constant);
+    Usage.ConstantBytes += Bytes;
+  }
+
+  // Operands of an MDNode are co-allocated value handles.
+  Usage.NumMDNodes = MDNodeSet.size() + NonUniquedMDNodes.size();
+  Usage.MDNodeBytes = Usage.NumMDNodes * sizeof(MDNode);
+  for (FoldingSetIterator<MDNode> I = MDNodeSet.begin(), E = MDNodeSet.end();
+       I != E; ++I)
+    Usage.MDNodeBytes += I->getNumOperands() * sizeof(CallbackVH);
+  for (SmallPtrSet<MDNode*, 1>::iterator I = NonUniquedMDNodes.begin(),
+         E = NonUniquedMDNodes.end(); I != E; ++I)
+    Usage.MDNodeBytes += (*I)->getNumOperands() * sizeof(CallbackVH);
+
+  Usage.NumMDStrings = MDStringCache.size();
+  Usage.MDStringBytes = 0;
+  for (StringMap<Value*>::iterator I = MDStringCache.begin(),
+         E = MDStringCache.end(); I != E; ++I)
+    Usage.MDStringBytes += sizeof(MDString) + I->getKeyLength();
+
+  Usage.NumTypes = IntegerTypes.size() + FunctionTypes.size() +
+                   AnonStructTypes.size() + NamedStructTypes.size() +
+                   ArrayTypes.size() + VectorTypes.size() +
+                   PointerTypes.size() + ASPointerTypes.size();
+  Usage.TypeBytes = TypeAllocator.getTotalMemory() +
+                    IntegerTypes.getMemorySize() +
+                    FunctionTypes.getMemorySize() +
+                    AnonStructTypes.getMemorySize() +
+                    ArrayTypes.getMemorySize() +
+                    VectorTypes.getMemorySize() +
+                    PointerTypes.getMemorySize() +
+                    ASPointerTypes.getMemorySize();
+
+  Usage.NumValueHandles = ValueHandles.size();
+  Usage.ValueHandleBytes = ValueHandles.getMemorySize();
+}
+
 // ConstantsContext anchors
 void UnaryConstantExpr::anchor() { }
 
@@ -221,7 +221,7 @@ class DebugRecVH : public CallbackVH {
   /// Ctx - This is the LLVM Context being referenced.
   LLVMContextImpl *Ctx;
   
-  /// Idx - The index into either ScopeRecordIdx or ScopeInlinedAtRecords that
+  /// Idx - The index into either ScopeRecords or ScopeInlinedAtRecords that
   /// this reference lives in.  If this is zero, then it represents a
   /// non-canonical entry that has no DenseMap value.  This can happen due to
   /// RAUW.
@@ -351,17 +351,25 @@ public:
   /// the MDNode is RAUW'd.
   std::vector<DebugRecVH> ScopeRecords;
   
-  /// ScopeInlinedAtIdx - This is the index in ScopeInlinedAtRecords for an
-  /// scope/inlined-at pair.
-  DenseMap<std::pair<MDNode*, MDNode*>, int> ScopeInlinedAtIdx;
+  /// ScopeInlinedAtIdx - This is the index in ScopeInlinedAtRecords for a
+  /// scope/inlined-at pair, keyed by the scope's index in ScopeRecords.
+  DenseMap<std::pair<int, MDNode*>, int> ScopeInlinedAtIdx;
   
-  /// ScopeInlinedAtRecords - These are the actual mdnodes (in value handles)
-  /// for an index.  The ValueHandle ensures that ScopeINlinedAtIdx stays up
-  /// to date.
-  std::vector<std::pair<DebugRecVH, DebugRecVH> > ScopeInlinedAtRecords;
+  /// ScopeInlinedAtRecords - These are the ScopeRecords index of the scope and
+  /// the inlined-at mdnode (in a value handle) for an index.  Sharing the
+  /// scope's record keeps this to one value handle per entry.  The
+  /// ValueHandle ensures that ScopeInlinedAtIdx stays up to date.
+  std::vector<std::pair<int, DebugRecVH> > ScopeInlinedAtRecords;
   
   int getOrAddScopeRecordIdxEntry(MDNode *N, int ExistingIdx);
-  int getOrAddScopeInlinedAtIdxEntry(MDNode *Scope, MDNode *IA,int ExistingIdx);
+  int getOrAddScopeInlinedAtIdxEntry(int ScopeIdx, MDNode *IA,int ExistingIdx);
+
+  /// getAllConstants - Append every uniqued constant in the context to
+  /// Constants.
+  void getAllConstants(SmallVectorImpl<Constant*> &Constants);
+
+  void getMemoryUsage(LLVMContext::MemoryUsage &Usage);
+  unsigned removeDeadConstantsAndMetadata();
   
   LLVMContextImpl(LLVMContext &C);
   ~LLVMContextImpl();
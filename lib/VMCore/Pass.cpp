@@ -190,7 +190,13 @@ const PassInfo *Pass::lookupPassInfo(StringRef Arg) {
 }
 
 Pass *Pass::createPass(AnalysisID ID) {
-  const PassInfo *PI = PassRegistry::getPassRegistry()->getPassInfo(ID);
+  PassRegistry *Registry = PassRegistry::getPassRegistry();
+  const PassInfo *PI = Registry->getPassInfo(ID);
+  if (!PI) {
+    // The pass may belong to a library whose initialization was deferred.
+    Registry->runDeferredInitializers();
+    PI = Registry->getPassInfo(ID);
+  }
   if (!PI)
     return NULL;
   return PI->createPass();
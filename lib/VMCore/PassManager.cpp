@@ -593,6 +593,12 @@ void PMTopLevelManager::schedulePass(Pass *P) {
       Pass *AnalysisPass = findAnalysisPass(*I);
       if (!AnalysisPass) {
         const PassInfo *PI = PassRegistry::getPassRegistry()->getPassInfo(*I);
+        if (PI == NULL) {
+          // The analysis may belong to a library whose initialization was
+          // deferred.
+          PassRegistry::getPassRegistry()->runDeferredInitializers();
+          PI = PassRegistry::getPassRegistry()->getPassInfo(*I);
+        }
 
         if (PI == NULL) {
           // Pass P is not in the global PassRegistry
@@ -58,6 +58,13 @@ struct PassRegistryImpl {
   
   std::vector<const PassInfo*> ToFree;
   std::vector<PassRegistrationListener*> Listeners;
+
+  /// DeferredInitializers - Initializers not yet run, in the order they were
+  /// queued.  NextDeferredInitializer is the index of the next one to run.
+  std::vector<PassRegistry::InitializerFn> DeferredInitializers;
+  unsigned NextDeferredInitializer;
+
+  PassRegistryImpl() : NextDeferredInitializer(0) {}
 };
 } // end anonymous namespace
 
@@ -93,9 +100,43 @@ const PassInfo *PassRegistry::getPassInfo(const void *TI) const {
 const PassInfo *PassRegistry::getPassInfo(StringRef Arg) const {
   sys::SmartScopedLock<true> Guard(*Lock);
   PassRegistryImpl *Impl = static_cast<PassRegistryImpl*>(getImpl());
-  PassRegistryImpl::StringMapType::const_iterator
-    I = Impl->PassInfoStringMap.find(Arg);
-  return I != Impl->PassInfoStringMap.end() ? I->second : 0;
+  do {
+    PassRegistryImpl::StringMapType::const_iterator
+      I = Impl->PassInfoStringMap.find(Arg);
+    if (I != Impl->PassInfoStringMap.end())
+      return I->second;
+  } while (runNextDeferredInitializer());
+  return 0;
+}
+
+//===----------------------------------------------------------------------===//
+// Deferred initialization
+//
+
+/// runNextDeferredInitializer - Run the oldest queued initializer.  Returns
+/// false if there was none.  The lock is recursive, so the initializer can
+/// register passes while it is held.
+bool PassRegistry::runNextDeferredInitializer() const {
+  sys::SmartScopedLock<true> Guard(*Lock);
+  PassRegistryImpl *Impl = static_cast<PassRegistryImpl*>(getImpl());
+  if (Impl->NextDeferredInitializer == Impl->DeferredInitializers.size())
+    return false;
+  InitializerFn Init =
+    Impl->DeferredInitializers[Impl->NextDeferredInitializer++];
+  Init(const_cast<PassRegistry&>(*this));
+  return true;
+}
+
+void PassRegistry::registerDeferredInitializer(InitializerFn Init) {
+  sys::SmartScopedLock<true> Guard(*Lock);
+  PassRegistryImpl *Impl = static_cast<PassRegistryImpl*>(getImpl());
+  Impl->DeferredInitializers.push_back(Init);
+}
+
+void PassRegistry::runDeferredInitializers() {
+  sys::SmartScopedLock<true> Guard(*Lock);
+  while (runNextDeferredInitializer())
+    ;
 }
 
 //===----------------------------------------------------------------------===//
@@ -133,6 +174,7 @@ void PassRegistry::unregisterPass(const PassInfo &PI) {
 
 void PassRegistry::enumerateWith(PassRegistrationListener *L) {
   sys::SmartScopedLock<true> Guard(*Lock);
+  runDeferredInitializers();
   PassRegistryImpl *Impl = static_cast<PassRegistryImpl*>(getImpl());
   for (PassRegistryImpl::MapType::const_iterator I = Impl->PassInfoMap.begin(),
        E = Impl->PassInfoMap.end(); I != E; ++I)
@@ -40,39 +40,8 @@ void TypeFinder::run(const Module &M, bool onlyNamed) {
   }
 
   // Get types from functions.
-  SmallVector<std::pair<unsigned, MDNode*>, 4> MDForInst;
-  for (Module::const_iterator FI = M.begin(), E = M.end(); FI != E; ++FI) {
-    incorporateType(FI->getType());
-
-    // First incorporate the arguments.
-    for (Function::const_arg_iterator AI = FI->arg_begin(),
-           AE = FI->arg_end(); AI != AE; ++AI)
-      incorporateValue(AI);
-
-    for (Function::const_iterator BB = FI->begin(), E = FI->end();
-         BB != E;++BB)
-      for (BasicBlock::const_iterator II = BB->begin(),
-             E = BB->end(); II != E; ++II) {
-        const Instruction &I = *II;
-
-        // Incorporate the type of the instruction.
-        incorporateType(I.getType());
-
-        // Incorporate non-instruction operand types. (We are incorporating all
-        // instructions with this loop.)
-        for (User::const_op_iterator OI = I.op_begin(), OE = I.op_end();
-             OI != OE; ++OI)
-          if (!isa<Instruction>(OI))
-            incorporateValue(*OI);
-
-        // Incorporate types hiding in metadata.
-        I.getAllMetadataOtherThanDebugLoc(MDForInst);
-        for (unsigned i = 0, e = MDForInst.size(); i != e; ++i)
-          incorporateMDNode(MDForInst[i].second);
-
-        MDForInst.clear();
-      }
-  }
+  for (Module::const_iterator FI = M.begin(), E = M.end(); FI != E; ++FI)
+    incorporateFunction(*FI);
 
   for (Module::const_named_metadata_iterator I = M.named_metadata_begin(),
          E = M.named_metadata_end(); I != E; ++I) {
@@ -82,6 +51,40 @@ void TypeFinder::run(const Module &M, bool onlyNamed) {
   }
 }
 
+void TypeFinder::incorporateFunction(const Function &F) {
+  incorporateType(F.getType());
+
+  // First incorporate the arguments.
+  for (Function::const_arg_iterator AI = F.arg_begin(),
+         AE = F.arg_end(); AI != AE; ++AI)
+    incorporateValue(AI);
+
+  SmallVector<std::pair<unsigned, MDNode*>, 4> MDForInst;
+  for (Function::const_iterator BB = F.begin(), E = F.end();
+       BB != E;++BB)
+    for (BasicBlock::const_iterator II = BB->begin(),
+           E = BB->end(); II != E; ++II) {
+      const Instruction &I = *II;
+
+      // Incorporate the type of the instruction.
+      incorporateType(I.getType());
+
+      // Incorporate non-instruction operand types. (We are incorporating all
+      // instructions with this loop.)
+      for (User::const_op_iterator OI = I.op_begin(), OE = I.op_end();
+           OI != OE; ++OI)
+        if (!isa<Instruction>(OI))
+          incorporateValue(*OI);
+
+      // Incorporate types hiding in metadata.
+      I.getAllMetadataOtherThanDebugLoc(MDForInst);
+      for (unsigned i = 0, e = MDForInst.size(); i != e; ++i)
+        incorporateMDNode(MDForInst[i].second);
+
+      MDForInst.clear();
+    }
+}
+
 void TypeFinder::clear() {
   VisitedConstants.clear();
   VisitedTypes.clear();
@@ -304,19 +304,36 @@ void Value::replaceAllUsesWith(Value *New) {
   if (HasValueHandle)
     ValueHandleBase::ValueIsRAUWd(this, New);
   
+  // Uses that can simply be retargeted are unlinked from this list and
+  // chained together, then spliced onto New's use list in one go.  Building
+  // the chain front to back keeps the order U.set(New) would give.
+  Use *Head = 0, *Last = 0;
   while (!use_empty()) {
     Use &U = *UseList;
     // Must handle Constants specially, we cannot call replaceUsesOfWith on a
     // constant because they are uniqued.
     if (Constant *C = dyn_cast<Constant>(U.getUser())) {
       if (!isa<GlobalValue>(C)) {
+        if (Head) {
+          Use::addRangeToList(Head, Last, &New->UseList);
+          Head = 0;
+        }
         C->replaceUsesOfWithOnConstant(this, New, &U);
         continue;
       }
     }
     
-    U.set(New);
+    U.removeFromList();
+    U.Val = New;
+    U.Next = Head;
+    if (Head)
+      Head->setPrev(&U.Next);
+    else
+      Last = &U;
+    Head = &U;
   }
+  if (Head)
+    Use::addRangeToList(Head, Last, &New->UseList);
   
   if (BasicBlock *BB = dyn_cast<BasicBlock>(this))
     BB->replaceSuccessorsPhiUsesWith(cast<BasicBlock>(New));
@@ -124,6 +124,8 @@ namespace {
     Module *Mod;          // Module we are verifying right now
     LLVMContext *Context; // Context within which we are verifying
     DominatorTree *DT;    // Dominator Tree, caution can be null!
+    VerifierLevel Level;  // Which checks to run.
+    bool StopAtFirstError; // Skip the remaining checks once broken.
 
     std::string Messages;
     raw_string_ostream MessagesStr;
@@ -146,12 +148,15 @@ namespace {
     Verifier()
       : FunctionPass(ID), Broken(false),
         action(AbortProcessAction), Mod(0), Context(0), DT(0),
+        Level(FullVerification), StopAtFirstError(false),
         MessagesStr(Messages), PersonalityFn(0) {
       initializeVerifierPass(*PassRegistry::getPassRegistry());
     }
-    explicit Verifier(VerifierFailureAction ctn)
+    explicit Verifier(VerifierFailureAction ctn,
+                      VerifierLevel level = FullVerification)
       : FunctionPass(ID), Broken(false), action(ctn), Mod(0),
-        Context(0), DT(0), MessagesStr(Messages), PersonalityFn(0) {
+        Context(0), DT(0), Level(level), StopAtFirstError(false),
+        MessagesStr(Messages), PersonalityFn(0) {
       initializeVerifierPass(*PassRegistry::getPassRegistry());
     }
 
@@ -165,8 +170,13 @@ namespace {
     }
 
     bool runOnFunction(Function &F) {
+      // Nobody is going to look at more than the first failure.
+      if (Broken && StopAtFirstError)
+        return false;
+
       // Get dominator information if we are being run by PassManager
-      DT = &getAnalysis<DominatorTree>();
+      if (Level == FullVerification)
+        DT = &getAnalysis<DominatorTree>();
 
       Mod = F.getParent();
       if (!Context) Context = &F.getContext();
@@ -181,6 +191,9 @@ namespace {
     }
 
     bool doFinalization(Module &M) {
+      if (Broken && StopAtFirstError)
+        return abortIfBroken();
+
       // Scan through, checking all of the external function's linkage now...
       for (Module::iterator I = M.begin(), E = M.end(); I != E; ++I) {
         visitGlobalValue(*I);
@@ -208,7 +221,8 @@ namespace {
     virtual void getAnalysisUsage(AnalysisUsage &AU) const {
       AU.setPreservesAll();
       AU.addRequiredID(PreVerifyID);
-      AU.addRequired<DominatorTree>();
+      if (Level == FullVerification)
+        AU.addRequired<DominatorTree>();
     }
 
     /// abortIfBroken - If the module is broken and we are supposed to abort on
@@ -1606,6 +1620,10 @@ void Verifier::visitLandingPadInst(LandingPadInst &LPI) {
 }
 
 void Verifier::verifyDominatesUse(Instruction &I, unsigned i) {
+  // Dominance is not checked by structural verification.
+  if (!DT)
+    return;
+
   Instruction *Op = cast<Instruction>(I.getOperand(i));
   // If the we have an invalid invoke, don't try to compute the dominance.
   // We already reject it in the invoke specific checks and the dominance
@@ -1626,7 +1644,9 @@ void Verifier::visitInstruction(Instruction &I) {
   BasicBlock *BB = I.getParent();
   Assert1(BB, "Instruction not embedded in basic block!", &I);
 
-  if (!isa<PHINode>(I)) {   // Check that non-phi nodes are not self referential
+  // Check that non-phi nodes are not self referential.  Telling whether the
+  // block is unreachable, where this is allowed, needs the dominator tree.
+  if (!isa<PHINode>(I) && DT) {
     for (Value::use_iterator UI = I.use_begin(), UE = I.use_end();
          UI != UE; ++UI)
       Assert1(*UI != (User*)&I || !DT->isReachableFromEntry(BB),
@@ -1926,20 +1946,22 @@ void Verifier::visitIntrinsicFunctionCall(Intrinsic::ID ID, CallInst &CI) {
 //  Implement the public interfaces to this file...
 //===----------------------------------------------------------------------===//
 
-FunctionPass *llvm::createVerifierPass(VerifierFailureAction action) {
-  return new Verifier(action);
+FunctionPass *llvm::createVerifierPass(VerifierFailureAction action,
+                                       VerifierLevel level) {
+  return new Verifier(action, level);
 }
 
 
 /// verifyFunction - Check a function for errors, printing messages on stderr.
 /// Return true if the function is corrupt.
 ///
-bool llvm::verifyFunction(const Function &f, VerifierFailureAction action) {
+bool llvm::verifyFunction(const Function &f, VerifierFailureAction action,
+                          VerifierLevel level) {
   Function &F = const_cast<Function&>(f);
   assert(!F.isDeclaration() && "Cannot verify external functions");
 
   FunctionPassManager FPM(F.getParent());
-  Verifier *V = new Verifier(action);
+  Verifier *V = new Verifier(action, level);
   FPM.add(V);
   FPM.run(F);
   return V->Broken;
@@ -1949,9 +1971,10 @@ bool llvm::verifyFunction(const Function &f, VerifierFailureAction action) {
 /// Return true if the module is corrupt.
 ///
 bool llvm::verifyModule(const Module &M, VerifierFailureAction action,
-                        std::string *ErrorInfo) {
+                        std::string *ErrorInfo, VerifierLevel level) {
   PassManager PM;
-  Verifier *V = new Verifier(action);
+  Verifier *V = new Verifier(action, level);
+  V->StopAtFirstError = action == ReturnStatusAction && !ErrorInfo;
   PM.add(V);
   PM.run(const_cast<Module&>(M));
 
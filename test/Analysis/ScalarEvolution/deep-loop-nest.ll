@@ -0,0 +1,76 @@
+; RUN: opt < %s -analyze -scalar-evolution | FileCheck %s
+;
+; Query trip counts and exit values in a deep loop nest. Every instruction is
+; evaluated at the scope of each enclosing loop, which exercises the
+; ValuesAtScopes and LoopDispositions caches across all levels of the nest.
+
+define i32 @nest(i32* %p) {
+entry:
+  br label %loop0
+
+loop0:
+  %iv0 = phi i32 [ 0, %entry ], [ %iv0.next, %latch0 ]
+  br label %loop1
+
+loop1:
+  %iv1 = phi i32 [ 0, %loop0 ], [ %iv1.next, %latch1 ]
+  br label %loop2
+
+loop2:
+  %iv2 = phi i32 [ 0, %loop1 ], [ %iv2.next, %latch2 ]
+  br label %loop3
+
+loop3:
+  %iv3 = phi i32 [ 0, %loop2 ], [ %iv3.next, %latch3 ]
+  br label %loop4
+
+loop4:
+  %iv4 = phi i32 [ 0, %loop3 ], [ %iv4.next, %latch4 ]
+  br label %loop5
+
+loop5:
+  %iv5 = phi i32 [ 0, %loop4 ], [ %iv5.next, %latch5 ]
+  br label %latch5
+
+latch5:
+  %sum = add i32 %iv0, %iv5
+  store i32 %sum, i32* %p
+  %iv5.next = add i32 %iv5, 1
+  %cmp5 = icmp ne i32 %iv5.next, 7
+  br i1 %cmp5, label %loop5, label %latch4
+
+latch4:
+  %iv4.next = add i32 %iv4, 1
+  %cmp4 = icmp ne i32 %iv4.next, 6
+  br i1 %cmp4, label %loop4, label %latch3
+
+latch3:
+  %iv3.next = add i32 %iv3, 1
+  %cmp3 = icmp ne i32 %iv3.next, 5
+  br i1 %cmp3, label %loop3, label %latch2
+
+latch2:
+  %iv2.next = add i32 %iv2, 1
+  %cmp2 = icmp ne i32 %iv2.next, 4
+  br i1 %cmp2, label %loop2, label %latch1
+
+latch1:
+  %iv1.next = add i32 %iv1, 1
+  %cmp1 = icmp ne i32 %iv1.next, 3
+  br i1 %cmp1, label %loop1, label %latch0
+
+latch0:
+  %iv0.next = add i32 %iv0, 1
+  %cmp0 = icmp ne i32 %iv0.next, 2
+  br i1 %cmp0, label %loop0, label %exit
+
+exit:
+  ret i32 %iv0.next
+}
+
+; CHECK: Loop %loop5: backedge-taken count is 6
+; CHECK: Loop %loop4: backedge-taken count is 5
+; CHECK: Loop %loop3: backedge-taken count is 4
+; CHECK: Loop %loop2: backedge-taken count is 3
+; CHECK: Loop %loop1: backedge-taken count is 2
+; CHECK: Loop %loop0: backedge-taken count is 1
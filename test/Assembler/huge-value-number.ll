@@ -0,0 +1,12 @@
+; The two largest value numbers are reserved by the parser's forward reference
+; tables; using them must be diagnosed rather than crash.
+; RUN: sed -e s/REF/%4294967295/ %s | not llvm-as -disable-output 2>&1 | FileCheck %s
+; RUN: sed -e s/REF/%4294967294/ %s | not llvm-as -disable-output 2>&1 | FileCheck %s
+; RUN: sed -e s/REF/@4294967295/ %s | not llvm-as -disable-output 2>&1 | FileCheck %s
+; RUN: sed -e s/REF/@4294967294/ %s | not llvm-as -disable-output 2>&1 | FileCheck %s
+
+; CHECK: invalid value number (too large)!
+
+define i32* @f() {
+  ret i32* REF
+}
@@ -0,0 +1,53 @@
+; RUN: llvm-as < %s | llvm-dis > %t.default
+; RUN: llvm-as -bitcode-adaptive-abbrevs < %s | llvm-dis > %t.adaptive
+; RUN: diff %t.default %t.adaptive
+; RUN: llvm-as < %s | llvm-bcanalyzer | FileCheck %s -check-prefix=DEFAULT
+; RUN: llvm-as -bitcode-adaptive-abbrevs < %s | llvm-bcanalyzer \
+; RUN:   | FileCheck %s -check-prefix=ADAPTIVE
+
+; With adaptive abbreviations, the llvm.dbg.value calls that dominate this
+; debug-info-heavy function get an abbreviation of their own and the function
+; block shrinks.  The module reads back the same either way.
+
+; DEFAULT: Block ID #12 (FUNCTION_BLOCK):
+; DEFAULT: Total Size: 765b/
+; DEFAULT: Record Histogram:
+; DEFAULT: 6 348 INST_CALL
+
+; ADAPTIVE: Block ID #12 (FUNCTION_BLOCK):
+; ADAPTIVE: Total Size: 501b/
+; ADAPTIVE: Record Histogram:
+; ADAPTIVE: 6 84 100.00 INST_CALL
+
+declare void @llvm.dbg.value(metadata, i64, metadata) nounwind readnone
+
+define i32 @f(i32 %a, i32 %b) nounwind {
+entry:
+  call void @llvm.dbg.value(metadata !{i32 %a}, i64 0, metadata !3), !dbg !10
+  call void @llvm.dbg.value(metadata !{i32 %b}, i64 0, metadata !4), !dbg !10
+  %x = add i32 %a, %b, !dbg !11
+  call void @llvm.dbg.value(metadata !{i32 %x}, i64 0, metadata !5), !dbg !11
+  %y = mul i32 %x, %a, !dbg !12
+  call void @llvm.dbg.value(metadata !{i32 %y}, i64 0, metadata !6), !dbg !12
+  %z = sub i32 %y, %b, !dbg !13
+  call void @llvm.dbg.value(metadata !{i32 %z}, i64 0, metadata !7), !dbg !13
+  %w = xor i32 %z, %x, !dbg !14
+  call void @llvm.dbg.value(metadata !{i32 %w}, i64 0, metadata !8), !dbg !14
+  ret i32 %w, !dbg !15
+}
+
+!0 = metadata !{metadata !"scope"}
+!1 = metadata !{metadata !"int"}
+!2 = metadata !{metadata !"file"}
+!3 = metadata !{i32 786689, metadata !0, metadata !"a", metadata !2, i32 1, metadata !1, i32 0, i32 0}
+!4 = metadata !{i32 786689, metadata !0, metadata !"b", metadata !2, i32 1, metadata !1, i32 0, i32 0}
+!5 = metadata !{i32 786688, metadata !0, metadata !"x", metadata !2, i32 2, metadata !1, i32 0, i32 0}
+!6 = metadata !{i32 786688, metadata !0, metadata !"y", metadata !2, i32 3, metadata !1, i32 0, i32 0}
+!7 = metadata !{i32 786688, metadata !0, metadata !"z", metadata !2, i32 4, metadata !1, i32 0, i32 0}
+!8 = metadata !{i32 786688, metadata !0, metadata !"w", metadata !2, i32 5, metadata !1, i32 0, i32 0}
+!10 = metadata !{i32 1, i32 3, metadata !0, null}
+!11 = metadata !{i32 2, i32 3, metadata !0, null}
+!12 = metadata !{i32 3, i32 3, metadata !0, null}
+!13 = metadata !{i32 4, i32 3, metadata !0, null}
+!14 = metadata !{i32 5, i32 3, metadata !0, null}
+!15 = metadata !{i32 6, i32 3, metadata !0, null}
@@ -0,0 +1,31 @@
+; RUN: llvm-as < %s | llvm-bcanalyzer -dump | FileCheck %s -check-prefix=BC
+; RUN: llvm-as < %s | llvm-dis | FileCheck %s
+
+; Branches and debug locations are written with abbreviations, and read back
+; unchanged.
+
+; BC: <INST_BR abbrevid=12
+; BC-NEXT: <DEBUG_LOC abbrevid=13 op0=3 op1=4
+; BC-NEXT: <INST_BR abbrevid=11
+; BC-NEXT: <DEBUG_LOC_AGAIN abbrevid=14/>
+; BC-NEXT: <INST_RET abbrevid=9
+; BC-NEXT: <DEBUG_LOC abbrevid=13 op0=5 op1=6
+
+define i32 @f(i1 %c) {
+entry:
+; CHECK: br i1 %c, label %a, label %b, !dbg ![[LOC1:[0-9]+]]
+  br i1 %c, label %a, label %b, !dbg !0
+a:
+; CHECK: br label %b, !dbg ![[LOC1]]
+  br label %b, !dbg !0
+b:
+; CHECK: ret i32 0, !dbg ![[LOC2:[0-9]+]]
+  ret i32 0, !dbg !2
+}
+
+; CHECK: ![[LOC1]] = metadata !{i32 3, i32 4, metadata ![[SCOPE:[0-9]+]], null}
+; CHECK: ![[LOC2]] = metadata !{i32 5, i32 6, metadata ![[SCOPE]], null}
+
+!0 = metadata !{i32 3, i32 4, metadata !1, null}
+!1 = metadata !{metadata !"scope"}
+!2 = metadata !{i32 5, i32 6, metadata !1, null}
@@ -0,0 +1,49 @@
+; RUN: llvm-as < %s | llvm-dis > %t0
+; RUN: llvm-as < %s | llvm-dis -lazy-functions > %t1
+; RUN: diff %t0 %t1
+; RUN: FileCheck %s < %t1
+
+; Types and metadata used only inside function bodies must still be printed
+; when the bodies are read in one at a time.
+
+; CHECK: %struct.pair = type { i32, i32 }
+
+%struct.pair = type { i32, i32 }
+
+@g = global i32 0
+
+; Reading bodies in one at a time must not drop the blocks that blockaddress
+; constants refer to.
+
+; CHECK: @tbl = constant [2 x i8*] [i8* blockaddress(@jump, %a), i8* blockaddress(@jump, %b)]
+@tbl = constant [2 x i8*] [i8* blockaddress(@jump, %a), i8* blockaddress(@jump, %b)]
+
+; CHECK: define internal i32 @first
+; CHECK-NOT: Materializable
+define internal i32 @first(%struct.pair* %p) {
+  %a = getelementptr %struct.pair* %p, i32 0, i32 1
+  %v = load i32* %a, !tbaa !0
+  ret i32 %v
+}
+
+; CHECK: define i32 @second
+define i32 @second() {
+  %p = alloca %struct.pair
+  %v = call i32 @first(%struct.pair* %p)
+  store i32 %v, i32* @g, !tbaa !0
+  ret i32 %v
+}
+
+; CHECK: define i32 @jump
+define i32 @jump(i8* %dest) {
+  indirectbr i8* %dest, [label %a, label %b]
+a:
+  ret i32 1
+b:
+  ret i32 2
+}
+
+; CHECK: !0 = metadata !{metadata !"int", metadata !1}
+!0 = metadata !{metadata !"int", metadata !1}
+!1 = metadata !{metadata !"root"}
+
@@ -0,0 +1,17 @@
+; RUN: llc < %s -mtriple=x86_64-pc-linux -filetype=obj -o %t1
+; RUN: llc < %s -mtriple=x86_64-pc-linux -filetype=obj -mmap-output -o %t2
+; RUN: cmp %t1 %t2
+
+; Writing the object file through a mapped buffer must not change its bytes.
+
+@msg = private constant [6 x i8] c"hello\00"
+
+define i8* @f(i32 %x) nounwind {
+entry:
+  %c = icmp eq i32 %x, 0
+  br i1 %c, label %a, label %b
+a:
+  ret i8* getelementptr ([6 x i8]* @msg, i32 0, i32 0)
+b:
+  ret i8* null
+}
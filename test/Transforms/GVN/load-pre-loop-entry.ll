@@ -0,0 +1,42 @@
+; RUN: opt -S -basicaa -gvn < %s | FileCheck %s
+; RUN: opt -S -basicaa -gvn -max-loop-load-pre-preds=1 < %s \
+; RUN:   | FileCheck %s -check-prefix=LIMIT
+
+; The loop header has two entering predecessors and the load is available
+; along the backedge, so it can be hoisted into both entry blocks.
+
+declare void @clobber()
+
+define i32 @test(i32* %p, i1 %c, i32 %n) {
+entry:
+  br i1 %c, label %a, label %b
+
+; CHECK: a:
+; CHECK: %v.pre{{[0-9]*}} = load i32* %p
+a:
+  call void @clobber()
+  br label %loop
+
+; CHECK: b:
+; CHECK: %v.pre{{[0-9]*}} = load i32* %p
+b:
+  br label %loop
+
+; CHECK: loop:
+; CHECK-NOT: load
+; CHECK: %v = phi i32
+; CHECK-NOT: load
+; LIMIT: loop:
+; LIMIT: %v = load i32* %p
+loop:
+  %i = phi i32 [ 0, %a ], [ 0, %b ], [ %i.next, %loop ]
+  %sum = phi i32 [ 0, %a ], [ 0, %b ], [ %sum.next, %loop ]
+  %v = load i32* %p
+  %sum.next = add i32 %sum, %v
+  %i.next = add i32 %i, 1
+  %cmp = icmp slt i32 %i.next, %n
+  br i1 %cmp, label %loop, label %exit
+
+exit:
+  ret i32 %sum.next
+}
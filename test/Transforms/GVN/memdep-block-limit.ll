@@ -0,0 +1,29 @@
+; RUN: opt < %s -basicaa -gvn -S | FileCheck %s
+; RUN: opt < %s -basicaa -gvn -memdep-block-number-limit=1 -S \
+; RUN:   | FileCheck %s -check-prefix=LIMIT
+
+; A non-local load whose dependencies are found within the block limit is
+; eliminated. Once the query has to visit more blocks than the limit allows,
+; memdep gives up and the load stays.
+
+define i32 @test(i32* %p, i1 %c) {
+entry:
+  store i32 42, i32* %p
+  br i1 %c, label %left, label %right
+
+left:
+  br label %merge
+
+right:
+  br label %merge
+
+merge:
+; CHECK: @test
+; CHECK-NOT: load
+; CHECK: ret i32 42
+; LIMIT: @test
+; LIMIT: %v = load i32* %p
+; LIMIT: ret i32 %v
+  %v = load i32* %p
+  ret i32 %v
+}
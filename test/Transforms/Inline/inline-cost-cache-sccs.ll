@@ -0,0 +1,82 @@
+; RUN: opt < %s -inline -inline-threshold=20 -stats -disable-output 2>&1 | FileCheck %s
+; REQUIRES: asserts
+;
+; A helper called from many SCCs is only costed once per argument bucket: its
+; summary survives from one SCC to the next, since only the functions of the
+; SCCs the inliner visits get changed. Call sites whose cost peeks into an
+; indirect call target are costed every time, as the target's body is not
+; part of the cache key.
+
+; The first @helper call, both @dispatch calls, and the two nested analyses of
+; @target.
+; CHECK: 5 inline-cost - Number of call sites analyzed
+; CHECK: 3 inline-cost - Number of call sites costed from the cache
+
+declare void @ext()
+
+define i32 @helper(i32 %x) {
+  %c = icmp ugt i32 %x, 42
+  br i1 %c, label %big, label %small
+big:
+  call void @ext()
+  call void @ext()
+  call void @ext()
+  call void @ext()
+  call void @ext()
+  call void @ext()
+  call void @ext()
+  call void @ext()
+  ret i32 %x
+small:
+  call void @ext()
+  call void @ext()
+  call void @ext()
+  call void @ext()
+  ret i32 0
+}
+
+define i32 @caller1() {
+  %r = call i32 @helper(i32 100)
+  ret i32 %r
+}
+
+define i32 @caller2() {
+  %r = call i32 @helper(i32 100)
+  ret i32 %r
+}
+
+define i32 @caller3() {
+  %r = call i32 @helper(i32 100)
+  ret i32 %r
+}
+
+define i32 @caller4() {
+  %r = call i32 @helper(i32 100)
+  ret i32 %r
+}
+
+define void @target() {
+  call void @ext()
+  ret void
+}
+
+define void @dispatch(void ()* %f) {
+  call void %f()
+  call void @ext()
+  call void @ext()
+  call void @ext()
+  call void @ext()
+  call void @ext()
+  call void @ext()
+  ret void
+}
+
+define void @caller5() {
+  call void @dispatch(void ()* @target)
+  ret void
+}
+
+define void @caller6() {
+  call void @dispatch(void ()* @target)
+  ret void
+}
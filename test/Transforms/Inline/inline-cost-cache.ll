@@ -0,0 +1,56 @@
+; RUN: opt < %s -inline -inline-threshold=20 -S | FileCheck %s
+;
+; Call sites of the same callee share cached cost summaries only when they
+; agree on every argument that can simplify the callee body. Check that the
+; cache does not leak a decision made for one constant argument to a call site
+; with a different one.
+
+declare void @ext()
+
+define i32 @callee(i32 %x) {
+  %icmp = icmp ugt i32 %x, 42
+  br i1 %icmp, label %bb.true, label %bb.false
+bb.true:
+  ; This block is only free when the condition folds to false.
+  call void @ext()
+  call void @ext()
+  call void @ext()
+  call void @ext()
+  call void @ext()
+  call void @ext()
+  call void @ext()
+  call void @ext()
+  ret i32 %x
+bb.false:
+  ret i32 %x
+}
+
+define i32 @caller1(i32 %y) {
+; CHECK: @caller1
+; CHECK-NOT: call i32 @callee(i32 1)
+; CHECK: call i32 @callee(i32 100)
+; CHECK: call i32 @callee(i32 %y)
+; CHECK-NOT: call i32 @callee(i32 2)
+; CHECK: ret
+
+  %a = call i32 @callee(i32 1)
+  %b = call i32 @callee(i32 100)
+  %c = call i32 @callee(i32 %y)
+  %d = call i32 @callee(i32 2)
+  %s1 = add i32 %a, %b
+  %s2 = add i32 %s1, %c
+  %s3 = add i32 %s2, %d
+  ret i32 %s3
+}
+
+define i32 @caller2(i32 %y) {
+; CHECK: @caller2
+; CHECK: call i32 @callee(i32 100)
+; CHECK-NOT: call i32 @callee(i32 1)
+; CHECK: ret
+
+  %a = call i32 @callee(i32 100)
+  %b = call i32 @callee(i32 1)
+  %s = add i32 %a, %b
+  ret i32 %s
+}
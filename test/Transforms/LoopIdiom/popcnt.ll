@@ -0,0 +1,94 @@
+; RUN: opt -loop-idiom -loop-idiom-ctpop < %s -S | FileCheck %s
+; RUN: opt -loop-idiom < %s -S | FileCheck %s -check-prefix=DISABLED
+target datalayout = "e-p:64:64:64-i1:8:8-i8:8:8-i16:16:16-i32:32:32-i64:64:64-f32:32:32-f64:64:64-v64:64:64-v128:128:128-a0:0:64-s0:64:64-f80:128:128-n8:16:32:64"
+target triple = "x86_64-apple-darwin10.0.0"
+
+; int popcount(unsigned long long x) {
+;   int cnt = 0;
+;   while (x) { x &= x - 1; cnt++; }
+;   return cnt;
+; }
+define i32 @popcount(i64 %x) nounwind readnone ssp {
+entry:
+  %tobool3 = icmp eq i64 %x, 0
+  br i1 %tobool3, label %while.end, label %while.body.preheader
+
+while.body.preheader:
+  br label %while.body
+
+while.body:
+  %cnt.05 = phi i32 [ %inc, %while.body ], [ 0, %while.body.preheader ]
+  %x.addr.04 = phi i64 [ %and, %while.body ], [ %x, %while.body.preheader ]
+  %sub = add i64 %x.addr.04, -1
+  %and = and i64 %sub, %x.addr.04
+  %inc = add nsw i32 %cnt.05, 1
+  %tobool = icmp eq i64 %and, 0
+  br i1 %tobool, label %while.end.loopexit, label %while.body
+
+while.end.loopexit:
+  %inc.lcssa = phi i32 [ %inc, %while.body ]
+  br label %while.end
+
+while.end:
+  %cnt.0.lcssa = phi i32 [ 0, %entry ], [ %inc.lcssa, %while.end.loopexit ]
+  ret i32 %cnt.0.lcssa
+; CHECK: @popcount
+; CHECK: while.body.preheader:
+; CHECK-NEXT: %popcnt = call i64 @llvm.ctpop.i64(i64 %x)
+; CHECK-NOT: select
+; CHECK: while.body:
+; CHECK: %tcphi = phi i64
+; CHECK: while.end.loopexit:
+; CHECK-NEXT: %inc.lcssa = phi i32 [ %popcnt.final, %while.body ]
+; DISABLED: @popcount
+; DISABLED-NOT: ctpop
+}
+
+; Without a guard the loop runs once even if the value is zero.
+define i32 @popcount_unguarded(i32 %x, i32 %start) nounwind readnone ssp {
+entry:
+  br label %loop
+
+loop:
+  %cnt = phi i32 [ %start, %entry ], [ %cnt.next, %loop ]
+  %v = phi i32 [ %x, %entry ], [ %v.next, %loop ]
+  %dec = add i32 %v, -1
+  %v.next = and i32 %v, %dec
+  %cnt.next = add i32 %cnt, 1
+  %cmp = icmp ne i32 %v.next, 0
+  br i1 %cmp, label %loop, label %exit
+
+exit:
+  %res = phi i32 [ %cnt.next, %loop ]
+  ret i32 %res
+; CHECK: @popcount_unguarded
+; CHECK: entry:
+; CHECK: %popcnt = call i32 @llvm.ctpop.i32(i32 %x)
+; CHECK: %popcnt.trip = select i1 {{.*}}, i32 1, i32 %popcnt
+; CHECK: %popcnt.final = add i32 %start, %popcnt.trip
+; CHECK: exit:
+; CHECK-NEXT: %res = phi i32 [ %popcnt.final, %loop ]
+}
+
+; Anything else in the loop body blocks the transformation.
+define i32 @popcount_store(i32 %x, i32* %p) nounwind ssp {
+entry:
+  br label %loop
+
+loop:
+  %cnt = phi i32 [ 0, %entry ], [ %cnt.next, %loop ]
+  %v = phi i32 [ %x, %entry ], [ %v.next, %loop ]
+  store i32 %v, i32* %p
+  %dec = add i32 %v, -1
+  %v.next = and i32 %v, %dec
+  %cnt.next = add i32 %cnt, 1
+  %cmp = icmp ne i32 %v.next, 0
+  br i1 %cmp, label %loop, label %exit
+
+exit:
+  %res = phi i32 [ %cnt.next, %loop ]
+  ret i32 %res
+; CHECK: @popcount_store
+; CHECK-NOT: ctpop
+; CHECK: ret i32
+}
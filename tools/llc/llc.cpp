@@ -25,6 +25,7 @@
 #include "llvm/MC/SubtargetFeature.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/FileOutputBuffer.h"
 #include "llvm/Support/FormattedStream.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/PluginLoader.h"
@@ -289,6 +290,10 @@ SSPBufferSize("stack-protector-buffer-size", cl::init(8),
               cl::desc("Lower bound for a buffer to be considered for "
                        "stack protection"));
 
+static cl::opt<bool>
+MmapOutput("mmap-output", cl::Hidden,
+  cl::desc("Write object files through a memory mapped output buffer"));
+
 // GetFileNameRoot - Helper function to get the basename of a filename.
 static inline std::string
 GetFileNameRoot(const std::string &InputFilename) {
@@ -306,10 +311,8 @@ GetFileNameRoot(const std::string &InputFilename) {
   return outputFilename;
 }
 
-static tool_output_file *GetOutputStream(const char *TargetName,
-                                         Triple::OSType OS,
-                                         const char *ProgName) {
-  // If we don't yet have an output filename, make one.
+// SetOutputFilename - If we don't yet have an output filename, make one.
+static void SetOutputFilename(const char *TargetName, Triple::OSType OS) {
   if (OutputFilename.empty()) {
     if (InputFilename == "-")
       OutputFilename = "-";
@@ -340,6 +343,12 @@ static tool_output_file *GetOutputStream(const char *TargetName,
       }
     }
   }
+}
+
+static tool_output_file *GetOutputStream(const char *TargetName,
+                                         Triple::OSType OS,
+                                         const char *ProgName) {
+  SetOutputFilename(TargetName, OS);
 
   // Decide if we need "binary" output.
   bool Binary = false;
@@ -516,10 +525,25 @@ int main(int argc, char **argv) {
              << ": warning: Win64 EH incompatible with non 64-bit arch\n";
   }
 
-  // Figure out where we are going to send the output.
-  OwningPtr<tool_output_file> Out
-    (GetOutputStream(TheTarget->getName(), TheTriple.getOS(), argv[0]));
-  if (!Out) return 1;
+  // Figure out where we are going to send the output.  Object files may be
+  // written straight into a mapping of the output file instead of through
+  // write(2); the mapping is discarded unless we commit it.
+  OwningPtr<tool_output_file> Out;
+  OwningPtr<raw_mmap_ostream> MmapOut;
+  SetOutputFilename(TheTarget->getName(), TheTriple.getOS());
+  if (MmapOutput && FileType == TargetMachine::CGFT_ObjectFile &&
+      OutputFilename != "-") {
+    std::string ErrorInfo;
+    MmapOut.reset(new raw_mmap_ostream(OutputFilename, ErrorInfo));
+    if (!ErrorInfo.empty()) {
+      errs() << ErrorInfo << '\n';
+      return 1;
+    }
+  } else {
+    Out.reset(GetOutputStream(TheTarget->getName(), TheTriple.getOS(),
+                              argv[0]));
+    if (!Out) return 1;
+  }
 
   // Build up all of the passes that we want to do to the module.
   PassManager PM;
@@ -548,7 +572,13 @@ int main(int argc, char **argv) {
   }
 
   {
-    formatted_raw_ostream FOS(Out->os());
+    // Keep the mapping as the write buffer so object code lands in place.
+    formatted_raw_ostream FOS;
+    if (MmapOut)
+      FOS.setStream(*MmapOut, formatted_raw_ostream::PRESERVE_STREAM,
+                    /*KeepStreamBuffer=*/true);
+    else
+      FOS.setStream(Out->os());
 
     AnalysisID StartAfterID = 0;
     AnalysisID StopAfterID = 0;
@@ -584,8 +614,17 @@ int main(int argc, char **argv) {
     PM.run(*mod);
   }
 
+  if (MmapOut) {
+    if (error_code EC = MmapOut->commit()) {
+      errs() << argv[0] << ": error writing '" << OutputFilename << "': "
+             << EC.message() << '\n';
+      return 1;
+    }
+  }
+
   // Declare success.
-  Out->keep();
+  if (Out)
+    Out->keep();
 
   return 0;
 }
@@ -23,6 +23,7 @@
 #include "llvm/IntrinsicInst.h"
 #include "llvm/Bitcode/ReaderWriter.h"
 #include "llvm/Assembly/AssemblyAnnotationWriter.h"
+#include "llvm/Assembly/Writer.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/DataStream.h"
 #include "llvm/Support/FormattedStream.h"
@@ -51,6 +52,10 @@ static cl::opt<bool>
 ShowAnnotations("show-annotations",
                 cl::desc("Add informational comments to the .ll file"));
 
+static cl::opt<bool>
+LazyFunctions("lazy-functions",
+              cl::desc("Read in and print one function body at a time"));
+
 namespace {
 
 static void printDebugLoc(const DebugLoc &DL, formatted_raw_ostream &OS) {
@@ -135,7 +140,8 @@ int main(int argc, char **argv) {
       DisplayFilename = InputFilename;
     M.reset(getStreamedBitcodeModule(DisplayFilename, streamer, Context,
                                      &ErrorMessage));
-    if(M.get() != 0 && M->MaterializeAllPermanently(&ErrorMessage)) {
+    if(M.get() != 0 && !LazyFunctions &&
+       M->MaterializeAllPermanently(&ErrorMessage)) {
       M.reset();
     }
   }
@@ -181,8 +187,15 @@ int main(int argc, char **argv) {
     Annotator.reset(new CommentWriter());
 
   // All that llvm-dis does is write the assembly to a file.
-  if (!DontPrint)
-    M->print(Out->os(), Annotator.get());
+  if (!DontPrint) {
+    if (!LazyFunctions)
+      M->print(Out->os(), Annotator.get());
+    else if (WriteModuleLazily(Out->os(), M.get(), Annotator.get(),
+                               &ErrorMessage)) {
+      errs() << argv[0] << ": " << ErrorMessage << "\n";
+      return 1;
+    }
+  }
 
   // Declare success.
   Out->keep();
@@ -0,0 +1,176 @@
+//===- llvm/unittest/ADT/FlatSparseBitVectorTest.cpp ----------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ADT/FlatSparseBitVector.h"
+#include "llvm/ADT/SparseBitVector.h"
+#include "gtest/gtest.h"
+#include <cstdlib>
+#include <vector>
+
+using namespace llvm;
+
+namespace {
+
+TEST(FlatSparseBitVectorTest, TrivialOperation) {
+  FlatSparseBitVector<> Vec;
+  EXPECT_EQ(0U, Vec.count());
+  EXPECT_FALSE(Vec.test(17));
+  Vec.set(5);
+  EXPECT_TRUE(Vec.test(5));
+  EXPECT_FALSE(Vec.test(17));
+  Vec.reset(6);
+  EXPECT_TRUE(Vec.test(5));
+  EXPECT_FALSE(Vec.test(6));
+  Vec.reset(5);
+  EXPECT_FALSE(Vec.test(5));
+  EXPECT_TRUE(Vec.empty());
+  EXPECT_TRUE(Vec.test_and_set(17));
+  EXPECT_FALSE(Vec.test_and_set(17));
+  EXPECT_TRUE(Vec.test(17));
+  Vec.clear();
+  EXPECT_FALSE(Vec.test(17));
+  EXPECT_EQ(-1, Vec.find_first());
+}
+
+TEST(FlatSparseBitVectorTest, Iteration) {
+  FlatSparseBitVector<> Vec;
+  EXPECT_TRUE(Vec.begin() == Vec.end());
+
+  unsigned Bits[] = { 0, 1, 63, 64, 127, 128, 1000, 1001, 100000 };
+  unsigned NumBits = sizeof(Bits) / sizeof(Bits[0]);
+  // Insert out of order to exercise insertion in the middle.
+  for (unsigned i = NumBits; i != 0; --i)
+    Vec.set(Bits[i - 1]);
+  EXPECT_EQ(NumBits, Vec.count());
+  EXPECT_EQ(0, Vec.find_first());
+
+  unsigned i = 0;
+  for (FlatSparseBitVector<>::iterator I = Vec.begin(), E = Vec.end(); I != E;
+       ++I, ++i) {
+    ASSERT_LT(i, NumBits);
+    EXPECT_EQ(Bits[i], *I);
+  }
+  EXPECT_EQ(NumBits, i);
+}
+
+TEST(FlatSparseBitVectorTest, SetOperations) {
+  FlatSparseBitVector<> A, B;
+  A.set(1);
+  A.set(200);
+  A.set(300);
+  B.set(200);
+  B.set(400);
+
+  EXPECT_TRUE(A.intersects(B));
+  EXPECT_FALSE(A.contains(B));
+
+  FlatSparseBitVector<> U = A | B;
+  EXPECT_EQ(4U, U.count());
+  EXPECT_TRUE(U.contains(A));
+  EXPECT_TRUE(U.contains(B));
+  EXPECT_FALSE(U |= A);
+
+  FlatSparseBitVector<> I = A & B;
+  EXPECT_EQ(1U, I.count());
+  EXPECT_TRUE(I.test(200));
+  EXPECT_FALSE(I &= A);
+
+  FlatSparseBitVector<> D = A - B;
+  EXPECT_EQ(2U, D.count());
+  EXPECT_TRUE(D.test(1));
+  EXPECT_TRUE(D.test(300));
+  EXPECT_FALSE(D.intersects(B));
+
+  EXPECT_TRUE(A.intersectWithComplement(B));
+  EXPECT_TRUE(A == D);
+  EXPECT_FALSE(A.intersectWithComplement(B));
+
+  // The three operand form may alias its destination.
+  U.intersectWithComplement(U, B);
+  EXPECT_TRUE(U == D);
+}
+
+template <typename SetT>
+static std::vector<unsigned> getBits(const SetT &Set) {
+  std::vector<unsigned> Bits;
+  for (typename SetT::iterator I = Set.begin(), E = Set.end(); I != E; ++I)
+    Bits.push_back(*I);
+  return Bits;
+}
+
+// Apply the same random operations to a SparseBitVector and a
+// FlatSparseBitVector and check that they always agree.
+template <unsigned ElementSize>
+static void checkSame(const SparseBitVector<ElementSize> &Ref,
+                      const FlatSparseBitVector<ElementSize> &Flat) {
+  ASSERT_EQ(getBits(Ref), getBits(Flat));
+  EXPECT_EQ(Ref.count(), Flat.count());
+  EXPECT_EQ(Ref.find_first(), Flat.find_first());
+  EXPECT_EQ(Ref.empty(), Flat.empty());
+}
+
+TEST(FlatSparseBitVectorTest, MatchesSparseBitVector) {
+  std::srand(42);
+  const unsigned NumSets = 4, Range = 2000;
+  SparseBitVector<> Ref[NumSets];
+  FlatSparseBitVector<> Flat[NumSets];
+
+  for (unsigned Step = 0; Step != 4000; ++Step) {
+    unsigned A = std::rand() % NumSets, B = std::rand() % NumSets;
+    unsigned Bit = std::rand() % Range;
+    switch (std::rand() % 8) {
+    case 0:
+    case 1:
+      Ref[A].set(Bit);
+      Flat[A].set(Bit);
+      break;
+    case 2:
+      Ref[A].reset(Bit);
+      Flat[A].reset(Bit);
+      break;
+    case 3:
+      EXPECT_EQ(Ref[A].test(Bit), Flat[A].test(Bit));
+      EXPECT_EQ(Ref[A].intersects(Ref[B]), Flat[A].intersects(Flat[B]));
+      EXPECT_EQ(Ref[A].contains(Ref[B]), Flat[A].contains(Flat[B]));
+      EXPECT_EQ(Ref[A] == Ref[B], Flat[A] == Flat[B]);
+      break;
+    case 4:
+      EXPECT_EQ(Ref[A] |= Ref[B], Flat[A] |= Flat[B]);
+      break;
+    case 5:
+      // Keep the sets from draining too fast.  SparseBitVector does not
+      // report a change when it drops whole elements, so check the result
+      // against a copy instead.
+      if (Step % 4 == 0) {
+        FlatSparseBitVector<> Old = Flat[A];
+        Ref[A] &= Ref[B];
+        bool Changed = Flat[A] &= Flat[B];
+        EXPECT_EQ(Old != Flat[A], Changed);
+      }
+      break;
+    case 6:
+      if (A != B && Step % 4 == 0)
+        EXPECT_EQ(Ref[A].intersectWithComplement(Ref[B]),
+                  Flat[A].intersectWithComplement(Flat[B]));
+      break;
+    case 7: {
+      unsigned C = std::rand() % NumSets;
+      if (C == A || C == B)
+        break;
+      Ref[C].intersectWithComplement(Ref[A], Ref[B]);
+      Flat[C].intersectWithComplement(Flat[A], Flat[B]);
+      checkSame(Ref[C], Flat[C]);
+      break;
+    }
+    }
+    checkSame(Ref[A], Flat[A]);
+  }
+}
+
+}
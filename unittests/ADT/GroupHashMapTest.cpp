@@ -0,0 +1,108 @@
+//===- llvm/unittest/ADT/GroupHashMapTest.cpp - GroupHashMap unit tests ---===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "gtest/gtest.h"
+#include "llvm/ADT/GroupHashMap.h"
+#include <string>
+
+using namespace llvm;
+
+namespace {
+
+TEST(GroupHashMapTest, EmptyMap) {
+  GroupHashMap<unsigned, unsigned> M;
+  EXPECT_TRUE(M.empty());
+  EXPECT_EQ(0u, M.size());
+  EXPECT_TRUE(M.begin() == M.end());
+  EXPECT_EQ(0u, M.count(0));
+  EXPECT_TRUE(M.find(0) == M.end());
+  EXPECT_EQ(0u, M.lookup(0));
+  EXPECT_FALSE(M.erase(0));
+  M.clear();
+}
+
+TEST(GroupHashMapTest, InsertFindErase) {
+  GroupHashMap<unsigned, unsigned> M;
+  EXPECT_TRUE(M.insert(std::make_pair(1u, 10u)).second);
+  EXPECT_FALSE(M.insert(std::make_pair(1u, 20u)).second);
+  EXPECT_EQ(1u, M.size());
+  EXPECT_EQ(10u, M.lookup(1));
+  EXPECT_EQ(10u, M.find(1)->second);
+
+  // No keys are reserved, so the DenseMap empty and tombstone keys work.
+  M[~0U] = 30;
+  M[~0U - 1] = 40;
+  EXPECT_EQ(30u, M.lookup(~0U));
+  EXPECT_EQ(40u, M.lookup(~0U - 1));
+  EXPECT_EQ(3u, M.size());
+
+  EXPECT_TRUE(M.erase(1));
+  EXPECT_FALSE(M.erase(1));
+  EXPECT_EQ(0u, M.count(1));
+  M.erase(M.find(~0U));
+  EXPECT_EQ(1u, M.size());
+  EXPECT_EQ(40u, M.begin()->second);
+}
+
+TEST(GroupHashMapTest, Grow) {
+  GroupHashMap<unsigned, unsigned> M;
+  const unsigned N = 10000;
+  for (unsigned i = 0; i != N; ++i)
+    M[i * 7] = i;
+  EXPECT_EQ(N, M.size());
+  for (unsigned i = 0; i != N; ++i) {
+    ASSERT_EQ(1u, M.count(i * 7));
+    EXPECT_EQ(i, M.lookup(i * 7));
+    EXPECT_EQ(0u, M.count(i * 7 + 1));
+  }
+
+  // Every entry is visited exactly once.
+  unsigned Sum = 0, Count = 0;
+  for (GroupHashMap<unsigned, unsigned>::const_iterator I = M.begin(),
+       E = M.end(); I != E; ++I) {
+    Sum += I->second;
+    ++Count;
+  }
+  EXPECT_EQ(N, Count);
+  EXPECT_EQ(N * (N - 1) / 2, Sum);
+}
+
+TEST(GroupHashMapTest, EraseAndReinsert) {
+  // Churn a small map so that tombstones have to be cleaned up.
+  GroupHashMap<unsigned, unsigned> M;
+  for (unsigned Round = 0; Round != 100; ++Round) {
+    for (unsigned i = 0; i != 50; ++i)
+      M[Round * 1000 + i] = i;
+    for (unsigned i = 0; i != 50; ++i)
+      EXPECT_TRUE(M.erase(Round * 1000 + i));
+    EXPECT_TRUE(M.empty());
+  }
+  EXPECT_LE(M.getMemorySize(), 128 * (sizeof(std::pair<unsigned, unsigned>) +
+                                      1));
+}
+
+TEST(GroupHashMapTest, NonPODValues) {
+  GroupHashMap<int, std::string> M;
+  for (int i = 0; i != 100; ++i)
+    M[i] = std::string(i, 'x');
+
+  GroupHashMap<int, std::string> Copy(M);
+  M.clear();
+  EXPECT_TRUE(M.empty());
+  EXPECT_EQ(100u, Copy.size());
+  EXPECT_EQ(std::string(42, 'x'), Copy.lookup(42));
+
+  M = Copy;
+  Copy.erase(42);
+  EXPECT_EQ(99u, Copy.size());
+  EXPECT_EQ(100u, M.size());
+  EXPECT_EQ(std::string(42, 'x'), M[42]);
+}
+
+} // end anonymous namespace
@@ -0,0 +1,58 @@
+//===- llvm/unittest/ADT/StatisticTest.cpp - Statistic unit tests ---------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#define DEBUG_TYPE "unittest"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+using namespace llvm;
+
+STATISTIC(Counter, "Counts \"things\"");
+
+namespace {
+
+TEST(StatisticTest, Count) {
+  EnableStatistics();
+  Counter = 0;
+  EXPECT_EQ(0u, Counter++);
+  EXPECT_EQ(2u, ++Counter);
+  EXPECT_EQ(2u, Counter--);
+  Counter += 4;
+  EXPECT_EQ(5u, Counter);
+
+  std::vector<const Statistic*> Stats;
+  GetStatistics(Stats);
+  const Statistic *Found = 0;
+  for (unsigned i = 0, e = Stats.size(); i != e; ++i)
+    if (Stats[i] == &Counter)
+      Found = Stats[i];
+  ASSERT_TRUE(Found != 0);
+  EXPECT_STREQ("unittest", Found->getName());
+  EXPECT_EQ(5u, Found->getValue());
+
+  // Values are read when asked for, not when registered.
+  ++Counter;
+  EXPECT_EQ(6u, Found->getValue());
+}
+
+TEST(StatisticTest, JSON) {
+  EnableStatistics();
+  Counter = 3;
+
+  SmallString<256> Buffer;
+  raw_svector_ostream OS(Buffer);
+  PrintStatisticsJSON(OS);
+  EXPECT_NE(StringRef::npos,
+            OS.str().find("{ \"name\": \"unittest\", "
+                          "\"desc\": \"Counts \\\"things\\\"\", "
+                          "\"value\": 3 }"));
+}
+
+} // end anonymous namespace
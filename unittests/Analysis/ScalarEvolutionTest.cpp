@@ -11,6 +11,7 @@
 #include "llvm/Analysis/LoopInfo.h"
 #include "llvm/GlobalVariable.h"
 #include "llvm/Constants.h"
+#include "llvm/Instructions.h"
 #include "llvm/LLVMContext.h"
 #include "llvm/Module.h"
 #include "llvm/PassManager.h"
@@ -230,5 +231,106 @@ TEST_F(ScalarEvolutionsTest, SCEVMultiplyAddRecs) {
   EXPECT_EQ(Product->getOperand(8), SE.getAddExpr(Sum));
 }
 
+// Query every value of a deep loop nest at every enclosing scope, and its
+// dominance of every block, the way LSR and IndVarSimplify do.  This is a
+// scaling test for the scope and disposition caches: it takes quadratic time
+// in the depth of the nest, and more if a cache lookup is not constant time.
+struct LoopNestQueries : public FunctionPass {
+  static char ID;
+  const std::vector<Instruction *> &Nexts;
+
+  explicit LoopNestQueries(const std::vector<Instruction *> &Nexts)
+    : FunctionPass(ID), Nexts(Nexts) {}
+
+  virtual void getAnalysisUsage(AnalysisUsage &AU) const {
+    AU.setPreservesAll();
+    AU.addRequired<LoopInfo>();
+    AU.addRequired<ScalarEvolution>();
+  }
+
+  void queryAll(Function &F) {
+    LoopInfo &LI = getAnalysis<LoopInfo>();
+    ScalarEvolution &SE = getAnalysis<ScalarEvolution>();
+    for (Function::iterator BB = F.begin(), E = F.end(); BB != E; ++BB)
+      for (BasicBlock::iterator I = BB->begin(), IE = BB->end(); I != IE; ++I) {
+        if (!SE.isSCEVable(I->getType()))
+          continue;
+        const SCEV *S = SE.getSCEV(I);
+        for (Loop *L = LI.getLoopFor(BB); L; L = L->getParentLoop()) {
+          SE.getSCEVAtScope(S, L->getParentLoop());
+          SE.isLoopInvariant(S, L);
+        }
+        for (Function::iterator BB2 = F.begin(); BB2 != E; ++BB2)
+          SE.properlyDominates(S, BB2);
+      }
+
+    // Leaving loop i, its induction variable has counted up to i + 2.
+    for (unsigned i = 0, e = Nexts.size(); i != e; ++i) {
+      const Loop *L = LI.getLoopFor(Nexts[i]->getParent());
+      const SCEV *Exit =
+        SE.getSCEVAtScope(SE.getSCEV(Nexts[i]), L->getParentLoop());
+      EXPECT_EQ(SE.getConstant(Nexts[i]->getType(), i + 2), Exit);
+    }
+  }
+
+  virtual bool runOnFunction(Function &F) {
+    queryAll(F);
+    // Forgetting the outermost loop drops the entries cached at the scope of
+    // every loop in the nest; the answers must not change.
+    getAnalysis<ScalarEvolution>().forgetLoop(
+      getAnalysis<LoopInfo>().getLoopFor(Nexts[0]->getParent()));
+    queryAll(F);
+    return false;
+  }
+};
+
+char LoopNestQueries::ID = 0;
+
+TEST_F(ScalarEvolutionsTest, DeepLoopNestScopes) {
+  const unsigned Depth = 100;
+  Type *Ty = Type::getInt32Ty(Context);
+  FunctionType *FTy = FunctionType::get(Type::getVoidTy(Context),
+                                        std::vector<Type *>(), false);
+  Function *F = cast<Function>(M.getOrInsertFunction("nest", FTy));
+
+  // entry -> header[0] -> ... -> header[Depth-1] -> latch[Depth-1] -> ...
+  // -> latch[0] -> exit, where latch[i] branches back to header[i] until the
+  // induction variable of loop i reaches i + 2.
+  BasicBlock *Entry = BasicBlock::Create(Context, "entry", F);
+  std::vector<BasicBlock *> Headers, Latches(Depth);
+  for (unsigned i = 0; i != Depth; ++i)
+    Headers.push_back(BasicBlock::Create(Context, "header", F));
+  for (unsigned i = Depth; i != 0; --i)
+    Latches[i - 1] = BasicBlock::Create(Context, "latch", F);
+  BasicBlock *Exit = BasicBlock::Create(Context, "exit", F);
+
+  BranchInst::Create(Headers[0], Entry);
+  std::vector<PHINode *> IVs;
+  for (unsigned i = 0; i != Depth; ++i) {
+    IVs.push_back(PHINode::Create(Ty, 2, "iv", Headers[i]));
+    BranchInst::Create(i + 1 != Depth ? Headers[i + 1] : Latches[i],
+                       Headers[i]);
+  }
+
+  std::vector<Instruction *> Nexts(Depth);
+  for (unsigned i = Depth; i != 0; --i) {
+    unsigned L = i - 1;
+    if (L == Depth - 1)
+      BinaryOperator::CreateAdd(IVs[0], IVs[L], "sum", Latches[L]);
+    Nexts[L] = BinaryOperator::CreateAdd(IVs[L], ConstantInt::get(Ty, 1),
+                                         "iv.next", Latches[L]);
+    ICmpInst *Cmp = new ICmpInst(*Latches[L], ICmpInst::ICMP_NE, Nexts[L],
+                                 ConstantInt::get(Ty, L + 2), "cmp");
+    BranchInst::Create(Headers[L], L ? Latches[L - 1] : Exit, Cmp, Latches[L]);
+    IVs[L]->addIncoming(ConstantInt::get(Ty, 0), L ? Headers[L - 1] : Entry);
+    IVs[L]->addIncoming(Nexts[L], Latches[L]);
+  }
+  ReturnInst::Create(Context, 0, Exit);
+
+  PM.add(&SE);
+  PM.add(new LoopNestQueries(Nexts));
+  PM.run(M);
+}
+
 }  // end anonymous namespace
 }  // end namespace llvm
@@ -7,6 +7,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "llvm/ADT/OwningPtr.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/Analysis/Verifier.h"
 #include "llvm/Bitcode/BitstreamWriter.h"
@@ -14,6 +15,7 @@
 #include "llvm/Constants.h"
 #include "llvm/Instructions.h"
 #include "llvm/LLVMContext.h"
+#include "llvm/Metadata.h"
 #include "llvm/Module.h"
 #include "llvm/PassManager.h"
 #include "llvm/Support/MemoryBuffer.h"
@@ -61,5 +63,101 @@ TEST(BitReaderTest, MaterializeFunctionsForBlockAddr) { // PR11677
   passes.run(*m);
 }
 
+// Adds a function named Name returning void, whose return carries !md
+// metadata with one string operand per entry of Strs.
+static void addFunctionWithMetadata(Module *Mod, const char *Name,
+                                    ArrayRef<const char *> Strs) {
+  LLVMContext &Ctx = Mod->getContext();
+  FunctionType *FuncTy = FunctionType::get(Type::getVoidTy(Ctx), false);
+  Function *Func = Function::Create(FuncTy, GlobalValue::ExternalLinkage,
+                                    Name, Mod);
+  BasicBlock *Entry = BasicBlock::Create(Ctx, "entry", Func);
+  ReturnInst *Ret = ReturnInst::Create(Ctx, Entry);
+
+  SmallVector<Value *, 4> Ops;
+  for (unsigned i = 0, e = Strs.size(); i != e; ++i)
+    Ops.push_back(MDString::get(Ctx, Strs[i]));
+  Ret->setMetadata("md", MDNode::get(Ctx, Ops));
+}
+
+TEST(BitReaderTest, MaterializeMetadataLazily) {
+  SmallString<1024> Mem;
+  {
+    Module Mod("test-md", getGlobalContext());
+    const char *First[] = { "one" };
+    const char *Second[] = { "two", "three" };
+    addFunctionWithMetadata(&Mod, "first", First);
+    addFunctionWithMetadata(&Mod, "second", Second);
+    raw_svector_ostream OS(Mem);
+    WriteBitcodeToFile(&Mod, OS);
+  }
+
+  LLVMContext Context;
+  LLVMContext::MemoryUsage Usage;
+  MemoryBuffer *Buffer = MemoryBuffer::getMemBuffer(Mem.str(), "test", false);
+  std::string ErrMsg;
+  OwningPtr<Module> M(getLazyBitcodeModule(Buffer, Context, &ErrMsg));
+  ASSERT_TRUE(M.get() != 0) << ErrMsg;
+
+  // Nothing refers to the metadata until a function is materialized.
+  Context.getMemoryUsage(Usage);
+  EXPECT_EQ(0u, Usage.NumMDStrings);
+
+  Function *F = M->getFunction("first");
+  ASSERT_FALSE(F->Materialize(&ErrMsg)) << ErrMsg;
+  Context.getMemoryUsage(Usage);
+  EXPECT_EQ(1u, Usage.NumMDStrings);
+
+  MDNode *N = F->getEntryBlock().getTerminator()->getMetadata("md");
+  ASSERT_TRUE(N != 0);
+  ASSERT_EQ(1u, N->getNumOperands());
+  EXPECT_EQ("one", cast<MDString>(N->getOperand(0))->getString());
+
+  ASSERT_FALSE(M->MaterializeAll(&ErrMsg)) << ErrMsg;
+  Context.getMemoryUsage(Usage);
+  EXPECT_EQ(3u, Usage.NumMDStrings);
+}
+
+// Emit an outer block with a record and an inner block, writing the inner
+// block into a buffer of its own and splicing it in if Split is set.
+static void writeNestedBlocks(SmallVectorImpl<char> &Out, bool Split) {
+  BitstreamWriter Stream(Out);
+  Stream.EnterBlockInfoBlock(2);
+  BitCodeAbbrev *Abbv = new BitCodeAbbrev();
+  Abbv->Add(BitCodeAbbrevOp(1));
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6));
+  unsigned AbbrevID = Stream.EmitBlockInfoAbbrev(8, Abbv);
+  Stream.ExitBlock();
+
+  SmallVector<unsigned, 2> Vals;
+  Stream.EnterSubblock(9, 3);
+  Vals.push_back(7);
+  Stream.EmitRecord(2, Vals);
+
+  SmallVector<char, 0> Buffer;
+  BitstreamWriter InnerStream(Buffer);
+  InnerStream.CopyBlockInfo(Stream);
+  BitstreamWriter &S = Split ? InnerStream : Stream;
+  S.EnterSubblock(8, 5);
+  for (unsigned i = 0; i != 10; ++i) {
+    Vals.clear();
+    Vals.push_back(i * 10);
+    S.EmitRecord(1, Vals, AbbrevID);
+  }
+  S.ExitBlock();
+  if (Split)
+    Stream.EmitSubblock(8, 5, Buffer);
+
+  Stream.EmitRecord(2, Vals);
+  Stream.ExitBlock();
+}
+
+TEST(BitstreamWriterTest, EmitSubblock) {
+  SmallVector<char, 0> Nested, Spliced;
+  writeNestedBlocks(Nested, false);
+  writeNestedBlocks(Spliced, true);
+  EXPECT_TRUE(Nested == Spliced);
+}
+
 }
 }
@@ -8,6 +8,9 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Support/Allocator.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/ThreadLocalAllocator.h"
+#include "llvm/Support/Threading.h"
 
 #include "gtest/gtest.h"
 #include <cstdlib>
@@ -148,4 +151,108 @@ TEST(AllocatorTest, TestBigAlignment) {
   EXPECT_LE(Ptr + 3000, ((uintptr_t)Slab) + Slab->Size);
 }
 
+// Reset(true) keeps the retired slabs and refills them before asking for more.
+TEST(AllocatorTest, TestResetKeepSlabs) {
+  BumpPtrAllocator Alloc(4096, 4096);
+  Alloc.Allocate(3000, 1);
+  Alloc.Allocate(3000, 1);
+  Alloc.Allocate(3000, 1);
+  EXPECT_EQ(3U, Alloc.GetNumSlabs());
+  size_t Total = Alloc.getTotalMemory();
+
+  Alloc.Reset(true);
+  EXPECT_EQ(1U, Alloc.GetNumSlabs());
+  EXPECT_EQ(Total, Alloc.getTotalMemory());
+
+  Alloc.Allocate(3000, 1);
+  Alloc.Allocate(3000, 1);
+  Alloc.Allocate(3000, 1);
+  EXPECT_EQ(3U, Alloc.GetNumSlabs());
+  EXPECT_EQ(Total, Alloc.getTotalMemory());
+
+  Alloc.Reset(true);
+  Alloc.Reset();
+  EXPECT_EQ(1U, Alloc.GetNumSlabs());
+  EXPECT_GT(Total, Alloc.getTotalMemory());
+}
+
+// Check the accounting of bytes lost to alignment and slab tails.
+TEST(AllocatorTest, TestWasteStats) {
+  BumpPtrAllocator Alloc(4096, 4096);
+  Alloc.Allocate(1, 1);
+  EXPECT_EQ(0U, Alloc.getAlignmentWaste());
+  Alloc.Allocate(8, 8);
+  EXPECT_EQ(7U, Alloc.getAlignmentWaste());
+  EXPECT_EQ(0U, Alloc.getSlabTailWaste());
+
+  // This does not fit in what is left of the first slab.
+  Alloc.Allocate(4076, 1);
+  EXPECT_EQ(2U, Alloc.GetNumSlabs());
+  EXPECT_LT(0U, Alloc.getSlabTailWaste());
+  EXPECT_EQ(4085U, Alloc.getBytesAllocated());
+}
+
+TEST(AllocatorTest, TestSizeClassAllocator) {
+  SizeClassAllocator<64, 16> Alloc;
+  void *A = Alloc.Allocate(10, 4);
+  void *B = Alloc.Allocate(20, 8);
+  EXPECT_EQ(0U, (uintptr_t)A % 16);
+  EXPECT_EQ(0U, (uintptr_t)B % 16);
+
+  // Freed blocks are reused for requests in the same size class.
+  Alloc.Deallocate(A, 10);
+  Alloc.Deallocate(B, 20);
+  EXPECT_EQ(48U, Alloc.getFreeBytes());
+  EXPECT_EQ(A, Alloc.Allocate(16, 1));
+  EXPECT_EQ(B, Alloc.Allocate(17, 16));
+  EXPECT_EQ(0U, Alloc.getFreeBytes());
+
+  // Large blocks are not recycled.
+  void *C = Alloc.Allocate(100, 8);
+  Alloc.Deallocate(C, 100);
+  EXPECT_EQ(0U, Alloc.getFreeBytes());
+
+  // Over-aligned requests never get a recycled block.
+  void *D = Alloc.Allocate(16, 1);
+  Alloc.Deallocate(D, 16);
+  EXPECT_EQ(0U, (uintptr_t)Alloc.Allocate(16, 64) % 64);
+  EXPECT_EQ(16U, Alloc.getFreeBytes());
+
+  Alloc.Reset();
+  EXPECT_EQ(0U, Alloc.getFreeBytes());
+}
+
+struct ThreadAllocData {
+  ThreadLocalBumpPtrAllocator *Alloc;
+  void *Ptr;
+};
+
+static void allocateOnThread(void *UserData) {
+  ThreadAllocData *Data = static_cast<ThreadAllocData*>(UserData);
+  Data->Ptr = Data->Alloc->Allocate(100, 8);
+  memset(Data->Ptr, 0xAB, 100);
+}
+
+TEST(AllocatorTest, TestThreadLocalAllocator) {
+  ThreadLocalBumpPtrAllocator Alloc;
+  EXPECT_EQ(0U, Alloc.getNumThreadAllocators());
+  void *Main = Alloc.Allocate(100, 8);
+  EXPECT_EQ(1U, Alloc.getNumThreadAllocators());
+  EXPECT_EQ(&Alloc.getThreadAllocator(), &Alloc.getThreadAllocator());
+
+  ThreadAllocData Data = { &Alloc, 0 };
+  llvm_execute_on_thread(allocateOnThread, &Data);
+  EXPECT_TRUE(Data.Ptr != 0);
+  EXPECT_NE(Main, Data.Ptr);
+  // Memory from the other thread outlives it.
+  EXPECT_EQ(0xAB, *static_cast<unsigned char*>(Data.Ptr));
+#if LLVM_ENABLE_THREADS
+  EXPECT_EQ(2U, Alloc.getNumThreadAllocators());
+#endif
+  EXPECT_EQ(200U, Alloc.getBytesAllocated());
+
+  Alloc.Reset();
+  EXPECT_EQ(Main, Alloc.Allocate(100, 8));
+}
+
 }  // anonymous namespace
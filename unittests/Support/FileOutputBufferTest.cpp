@@ -8,9 +8,12 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/FileOutputBuffer.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/FormattedStream.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/PathV2.h"
 #include "llvm/Support/raw_ostream.h"
 
@@ -127,6 +130,111 @@ TEST(FileOutputBuffer, Test) {
   bool IsExecutable = (Status.permissions() & fs::owner_exe);
   EXPECT_TRUE(IsExecutable);
 
+
+  // TEST 5: Verify growing the buffer keeps its content.
+  SmallString<128> File5(TestDirectory);
+  File5.append("/file5");
+  {
+    OwningPtr<FileOutputBuffer> Buffer;
+    ASSERT_NO_ERROR(FileOutputBuffer::create(File5, 8192, Buffer));
+    memcpy(Buffer->getBufferStart(), "AABBCCDDEEFFGGHHIIJJ", 20);
+    ASSERT_NO_ERROR(Buffer->extend(100000));
+    ASSERT_EQ(Buffer->getBufferSize(), 100000U);
+    // Write to end of buffer to verify it is writable.
+    memcpy(Buffer->getBufferEnd() - 20, "AABBCCDDEEFFGGHHIIJJ", 20);
+    ASSERT_NO_ERROR(Buffer->commit());
+  }
+  bool MagicMatches5 = false;
+  ASSERT_NO_ERROR(fs::has_magic(Twine(File5), Twine("AABBCCDDEEFFGGHHIIJJ"),
+                                MagicMatches5));
+  EXPECT_TRUE(MagicMatches5);
+  uint64_t File5Size;
+  ASSERT_NO_ERROR(fs::file_size(Twine(File5), File5Size));
+  ASSERT_EQ(File5Size, 100000ULL);
+
+
+  // TEST 6: Verify raw_mmap_ostream grows past its size hint and trims the
+  // file to what was written.
+  SmallString<128> File6(TestDirectory);
+  File6.append("/file6");
+  std::string Expected;
+  {
+    std::string ErrorInfo;
+    raw_mmap_ostream OS(File6.str(), ErrorInfo, 4096);
+    ASSERT_TRUE(ErrorInfo.empty());
+    for (unsigned i = 0; i != 200000; ++i) {
+      OS << i << ' ';
+      Expected += utostr(i) + ' ';
+    }
+    // A write larger than the buffer goes around it.
+    std::string Large(3 << 20, 'x');
+    OS << Large;
+    Expected += Large;
+    OS.flush();
+    EXPECT_EQ(Expected.size(), OS.tell());
+    ASSERT_NO_ERROR(OS.commit());
+    EXPECT_FALSE(OS.has_error());
+  }
+  OwningPtr<MemoryBuffer> Contents;
+  ASSERT_NO_ERROR(MemoryBuffer::getFile(File6.str(), Contents));
+  EXPECT_TRUE(Contents->getBuffer() == Expected);
+
+  // TEST 7: Verify raw_mmap_ostream discards the file unless committed.
+  SmallString<128> File7(TestDirectory);
+  File7.append("/file7");
+  {
+    std::string ErrorInfo;
+    raw_mmap_ostream OS(File7.str(), ErrorInfo);
+    ASSERT_TRUE(ErrorInfo.empty());
+    OS << "AABBCCDDEEFFGGHHIIJJ";
+  }
+  ASSERT_NO_ERROR(fs::exists(Twine(File7), Exists));
+  EXPECT_FALSE(Exists);
+
+  // TEST 8: Verify a failed commit does not leave the temp file behind.
+  SmallString<128> File8(TestDirectory);
+  File8.append("/file8");
+  {
+    OwningPtr<FileOutputBuffer> Buffer;
+    ASSERT_NO_ERROR(FileOutputBuffer::create(File8, 4096, Buffer));
+    // A directory in the way makes the final rename fail.
+    SmallString<128> Blocker(File8);
+    Blocker.append("/blocker");
+    ASSERT_NO_ERROR(fs::create_directories(Twine(Blocker), Exists));
+    EXPECT_TRUE(Buffer->commit() != errc::success);
+  }
+  unsigned NumTempFiles = 0;
+  error_code EC;
+  for (fs::directory_iterator I(Twine(TestDirectory), EC), E; I != E && !EC;
+       I.increment(EC))
+    if (path::filename(I->path()).startswith("file8.tmp"))
+      ++NumTempFiles;
+  ASSERT_NO_ERROR(EC);
+  EXPECT_EQ(0U, NumTempFiles);
+
+  // TEST 9: Verify a formatted_raw_ostream can write into the mapping without
+  // taking over its buffering.
+  SmallString<128> File9(TestDirectory);
+  File9.append("/file9");
+  {
+    std::string ErrorInfo;
+    raw_mmap_ostream OS(File9.str(), ErrorInfo);
+    ASSERT_TRUE(ErrorInfo.empty());
+    {
+      formatted_raw_ostream FOS(OS, formatted_raw_ostream::PRESERVE_STREAM,
+                                /*KeepStreamBuffer=*/true);
+      EXPECT_NE(0U, OS.GetBufferSize());
+      EXPECT_EQ(0U, FOS.GetBufferSize());
+      FOS << "AABB";
+      FOS.PadToColumn(8);
+      FOS << "CC";
+    }
+    EXPECT_NE(0U, OS.GetBufferSize());
+    ASSERT_NO_ERROR(OS.commit());
+  }
+  ASSERT_NO_ERROR(MemoryBuffer::getFile(File9.str(), Contents));
+  EXPECT_TRUE(Contents->getBuffer() == "AABB    CC");
+
   // Clean up.
   uint32_t RemovedCount;
   ASSERT_NO_ERROR(fs::remove_all(TestDirectory.str(), RemovedCount));
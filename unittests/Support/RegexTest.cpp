@@ -91,4 +91,48 @@ TEST_F(RegexTest, Substitution) {
   EXPECT_EQ(Error, "invalid backreference string '100'");
 }
 
+TEST_F(RegexTest, LiteralPrefix) {
+  SmallVector<StringRef, 2> Matches;
+
+  // Patterns that start with a literal skip ahead to its occurrences; make
+  // sure that finds the leftmost match and keeps anchors and groups working.
+  Regex r1("(ab)+c", Regex::Newline);
+  EXPECT_TRUE(r1.match("xaabxababcab", &Matches));
+  EXPECT_EQ("ababc", Matches[0].str());
+  EXPECT_EQ("ab", Matches[1].str());
+  EXPECT_FALSE(r1.match("xaabxababab"));
+
+  Regex r2("x=[0-9]+$", Regex::Newline);
+  EXPECT_TRUE(r2.match("x=1a\nx=x\nx=23\n", &Matches));
+  EXPECT_EQ("x=23", Matches[0].str());
+
+  StringRef Words("ab a.");
+  Regex r3("a[[:>:]]");
+  EXPECT_TRUE(r3.match(Words, &Matches));
+  EXPECT_EQ(3, Matches[0].data() - Words.data());
+}
+
+// Match against a few megabytes of assembly-like text, which is what FileCheck
+// spends its time on.  This doubles as a throughput benchmark; run it alone with
+// --gtest_filter to see the time.
+TEST_F(RegexTest, LargeInput) {
+  std::string Text;
+  for (unsigned i = 0; i != 100000; ++i)
+    Text += "\tmovl\t%eax, 8(%esp)\n\taddl\t$4, %ecx\n";
+  Text += "\tcall\tfoo@PLT\n";
+
+  SmallVector<StringRef, 2> Matches;
+  Regex Prefixed("call[[:space:]]+([a-z]+)@PLT", Regex::Newline);
+  ASSERT_TRUE(Prefixed.match(Text, &Matches));
+  EXPECT_EQ("foo", Matches[1].str());
+  EXPECT_EQ(Text.size() - 13, size_t(Matches[0].data() - Text.data()));
+
+  Regex Unprefixed("[a-z]+l[[:space:]]+foo", Regex::Newline);
+  ASSERT_TRUE(Unprefixed.match(Text, &Matches));
+  EXPECT_EQ("call\tfoo", Matches[0].str());
+
+  Regex Missing("jmp[[:space:]]+foo", Regex::Newline);
+  EXPECT_FALSE(Missing.match(Text));
+}
+
 }
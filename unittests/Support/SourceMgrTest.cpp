@@ -0,0 +1,59 @@
+//===- unittests/Support/SourceMgrTest.cpp - SourceMgr tests --------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+
+namespace {
+
+// Return the line and column of Offset by counting from the start of Buf.
+static std::pair<unsigned, unsigned> countLineAndColumn(StringRef Buf,
+                                                        size_t Offset) {
+  unsigned Line = 1, Column = 1;
+  for (size_t i = 0; i != Offset; ++i, ++Column)
+    if (Buf[i] == '\n') {
+      ++Line;
+      Column = 0;
+    }
+  return std::make_pair(Line, Column);
+}
+
+TEST(SourceMgrTest, LineAndColumn) {
+  SourceMgr SM;
+  std::string Text1, Text2 = "\n\nx\n";
+  for (unsigned i = 0; i != 500; ++i)
+    Text1 += std::string(i % 7, ' ') + "line\n";
+  Text1 += "last";
+  unsigned ID1 = SM.AddNewSourceBuffer(MemoryBuffer::getMemBuffer(Text1),
+                                       SMLoc());
+  unsigned ID2 = SM.AddNewSourceBuffer(MemoryBuffer::getMemBuffer(Text2),
+                                       SMLoc());
+
+  // Query out of order and alternate between the buffers, so that both
+  // extending the index and searching it are exercised.
+  const char *Start1 = SM.getMemoryBuffer(ID1)->getBufferStart();
+  const char *Start2 = SM.getMemoryBuffer(ID2)->getBufferStart();
+  size_t Offsets[] = { 1000, 10, 0, 2000, 1999, Text1.size(), 5, 1500 };
+  for (unsigned i = 0; i != sizeof(Offsets) / sizeof(Offsets[0]); ++i) {
+    size_t Offset = Offsets[i];
+    EXPECT_EQ(countLineAndColumn(Text1, Offset),
+              SM.getLineAndColumn(SMLoc::getFromPointer(Start1 + Offset)));
+    size_t Offset2 = Offset % (Text2.size() + 1);
+    EXPECT_EQ(countLineAndColumn(Text2, Offset2),
+              SM.getLineAndColumn(SMLoc::getFromPointer(Start2 + Offset2),
+                                  ID2));
+  }
+  EXPECT_EQ(501U, SM.FindLineNumber(SMLoc::getFromPointer(Start1 +
+                                                          Text1.size())));
+}
+
+}
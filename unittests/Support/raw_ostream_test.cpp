@@ -9,7 +9,9 @@
 
 #include "gtest/gtest.h"
 #include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Format.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/raw_ostream.h"
 
 using namespace llvm;
@@ -143,4 +145,71 @@ TEST(raw_ostreamTest, WriteEscaped) {
   EXPECT_EQ("\\001\\010\\200", Str);
 }
 
+/// raw_recording_ostream - Collect the output and the number of calls to
+/// write_impl and writev_impl.
+class raw_recording_ostream : public raw_ostream {
+  virtual void write_impl(const char *Ptr, size_t Size) {
+    ++NumWrites;
+    Data.append(Ptr, Size);
+  }
+  virtual void writev_impl(const char *Ptr1, size_t Size1,
+                           const char *Ptr2, size_t Size2) {
+    ++NumVectorWrites;
+    Data.append(Ptr1, Size1);
+    Data.append(Ptr2, Size2);
+  }
+  virtual uint64_t current_pos() const { return Data.size(); }
+
+public:
+  std::string Data;
+  unsigned NumWrites, NumVectorWrites;
+
+  raw_recording_ostream() : NumWrites(0), NumVectorWrites(0) {}
+  ~raw_recording_ostream() { flush(); }
+};
+
+TEST(raw_ostreamTest, LargeWrite) {
+  raw_recording_ostream OS;
+  OS.SetBufferSize(16);
+  std::string Big(40, 'x');
+
+  // A large string following buffered data is written along with it, in
+  // whole buffers, and the rest is buffered.
+  OS << "abc" << Big;
+  EXPECT_EQ(0U, OS.NumWrites);
+  EXPECT_EQ(1U, OS.NumVectorWrites);
+  EXPECT_EQ(32U, OS.Data.size());
+  EXPECT_EQ(11U, OS.GetNumBytesInBuffer());
+
+  // With an empty buffer it is written directly.
+  OS.flush();
+  EXPECT_EQ(1U, OS.NumWrites);
+  OS << Big;
+  EXPECT_EQ(2U, OS.NumWrites);
+  EXPECT_EQ(8U, OS.GetNumBytesInBuffer());
+
+  OS.flush();
+  EXPECT_EQ("abc" + Big + Big, OS.Data);
+}
+
+TEST(raw_ostreamTest, LargeWriteToFile) {
+  int FD;
+  SmallString<64> Path;
+  ASSERT_FALSE(sys::fs::unique_file("raw-ostream-test-%%%%%%", FD, Path));
+
+  std::string Big(100000, 'x');
+  Big[50000] = 'y';
+  {
+    raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    OS << "abc" << Big << "def";
+    EXPECT_EQ(100006U, OS.tell());
+  }
+
+  OwningPtr<MemoryBuffer> Buf;
+  ASSERT_FALSE(MemoryBuffer::getFile(Path.str(), Buf));
+  EXPECT_EQ("abc" + Big + "def", Buf->getBuffer().str());
+  bool Existed;
+  sys::fs::remove(Path.str(), Existed);
+}
+
 }
@@ -0,0 +1,86 @@
+//===- llvm/unittest/VMCore/DebugLocTest.cpp - DebugLoc unit tests --------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/LLVMContext.h"
+#include "llvm/Metadata.h"
+#include "llvm/Support/DebugLoc.h"
+#include "gtest/gtest.h"
+using namespace llvm;
+
+namespace {
+
+class DebugLocTest : public testing::Test {
+protected:
+  LLVMContext Context;
+
+  MDNode *getNode(StringRef Name) {
+    Value *V = MDString::get(Context, Name);
+    return MDNode::get(Context, V);
+  }
+};
+
+TEST_F(DebugLocTest, InlinedAt) {
+  MDNode *Scope = getNode("scope");
+  MDNode *IA1 = getNode("ia1");
+  MDNode *IA2 = getNode("ia2");
+
+  DebugLoc Plain = DebugLoc::get(3, 4, Scope);
+  DebugLoc DL1 = DebugLoc::get(3, 4, Scope, IA1);
+  DebugLoc DL2 = DebugLoc::get(3, 4, Scope, IA2);
+  EXPECT_NE(Plain, DL1);
+  EXPECT_NE(DL1, DL2);
+  EXPECT_EQ(DL1, DebugLoc::get(3, 4, Scope, IA1));
+
+  EXPECT_EQ(3u, DL1.getLine());
+  EXPECT_EQ(4u, DL1.getCol());
+  EXPECT_EQ(Scope, Plain.getScope(Context));
+  EXPECT_EQ(Scope, DL1.getScope(Context));
+  EXPECT_EQ(Scope, DL2.getScope(Context));
+  EXPECT_EQ(0, Plain.getInlinedAt(Context));
+  EXPECT_EQ(IA1, DL1.getInlinedAt(Context));
+  EXPECT_EQ(IA2, DL2.getInlinedAt(Context));
+}
+
+TEST_F(DebugLocTest, ReplaceScope) {
+  MDNode *IA = getNode("ia");
+  Value *V = MDString::get(Context, "temp");
+  MDNode *Temp = MDNode::getTemporary(Context, V);
+  DebugLoc DL = DebugLoc::get(1, 2, Temp, IA);
+
+  MDNode *Scope = getNode("scope");
+  Temp->replaceAllUsesWith(Scope);
+  MDNode::deleteTemporary(Temp);
+
+  MDNode *S, *I;
+  DL.getScopeAndInlinedAt(S, I, Context);
+  EXPECT_EQ(Scope, S);
+  EXPECT_EQ(IA, I);
+  EXPECT_EQ(DL, DebugLoc::get(1, 2, Scope, IA));
+}
+
+TEST_F(DebugLocTest, ReplaceInlinedAt) {
+  MDNode *Scope = getNode("scope");
+  MDNode *IA = getNode("ia");
+  Value *V = MDString::get(Context, "temp");
+  MDNode *Temp = MDNode::getTemporary(Context, V);
+
+  // Replacing the inlined-at node with one that already has an entry leaves
+  // the old entry as a non-canonical alias of it.
+  DebugLoc Existing = DebugLoc::get(5, 6, Scope, IA);
+  DebugLoc DL = DebugLoc::get(5, 6, Scope, Temp);
+  Temp->replaceAllUsesWith(IA);
+  MDNode::deleteTemporary(Temp);
+
+  EXPECT_EQ(Scope, DL.getScope(Context));
+  EXPECT_EQ(IA, DL.getInlinedAt(Context));
+  EXPECT_EQ(IA, Existing.getInlinedAt(Context));
+  EXPECT_EQ(Existing, DebugLoc::get(5, 6, Scope, IA));
+}
+
+}  // end anonymous namespace
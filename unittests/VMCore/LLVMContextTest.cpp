@@ -0,0 +1,89 @@
+//===- llvm/unittest/VMCore/LLVMContextTest.cpp - LLVMContext unit tests --===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Constants.h"
+#include "llvm/DerivedTypes.h"
+#include "llvm/GlobalVariable.h"
+#include "llvm/LLVMContext.h"
+#include "llvm/Metadata.h"
+#include "llvm/Module.h"
+#include "llvm/Support/ValueHandle.h"
+#include "gtest/gtest.h"
+using namespace llvm;
+
+namespace {
+
+TEST(LLVMContextTest, RemoveDeadConstantsAndMetadata) {
+  LLVMContext C;
+  Module M("test", C);
+  Type *Int64Ty = Type::getInt64Ty(C);
+  GlobalVariable *G = new GlobalVariable(M, Int64Ty, false,
+                                         GlobalValue::ExternalLinkage, 0, "g");
+
+  // A chain of dead constant expressions, referenced only by a dead node.
+  Constant *Sum = ConstantExpr::getAdd(ConstantExpr::getPtrToInt(G, Int64Ty),
+                                       ConstantInt::get(Int64Ty, 1));
+  Value *Ops[] = { MDString::get(C, "dead"), Sum };
+  MDNode::get(C, Ops);
+
+  // A constant with a value handle must survive.
+  WeakVH Kept(ConstantInt::get(Int64Ty, 42));
+
+  LLVMContext::MemoryUsage Before;
+  C.getMemoryUsage(Before);
+  EXPECT_EQ(1u, Before.NumMDNodes);
+  EXPECT_EQ(1u, Before.NumMDStrings);
+
+  EXPECT_NE(0u, C.removeDeadConstantsAndMetadata());
+
+  LLVMContext::MemoryUsage After;
+  C.getMemoryUsage(After);
+  EXPECT_EQ(0u, After.NumMDNodes);
+  EXPECT_EQ(0u, After.NumMDStrings);
+  EXPECT_LT(After.NumConstants, Before.NumConstants);
+  EXPECT_LT(After.ConstantBytes, Before.ConstantBytes);
+
+  Value *V = Kept;
+  EXPECT_TRUE(V != 0);
+  EXPECT_TRUE(G->use_empty());
+
+  // Everything dead is gone after one call.
+  EXPECT_EQ(0u, C.removeDeadConstantsAndMetadata());
+}
+
+TEST(LLVMContextTest, RemoveDeadConstantDataChains) {
+  LLVMContext C;
+  Module M("test", C);
+
+  // These all have the same raw data, so they share one uniquing map entry
+  // and the later ones are chained off the first.
+  uint8_t Bytes[] = { 1, 2, 3, 4 };
+  uint16_t Halves[] = { 0, 0 };
+  uint32_t Word = 0;
+  memcpy(Halves, Bytes, sizeof(Bytes));
+  memcpy(&Word, Bytes, sizeof(Bytes));
+  Constant *Head = ConstantDataArray::get(C, Bytes);
+  ConstantDataArray::get(C, Halves);
+  ConstantDataArray::get(C, ArrayRef<uint32_t>(Word));
+
+  // Keep the head alive; the dead entries behind it must still be freed.
+  new GlobalVariable(M, Head->getType(), true, GlobalValue::ExternalLinkage,
+                     Head, "g");
+
+  LLVMContext::MemoryUsage Before;
+  C.getMemoryUsage(Before);
+  EXPECT_EQ(2u, C.removeDeadConstantsAndMetadata());
+
+  LLVMContext::MemoryUsage After;
+  C.getMemoryUsage(After);
+  EXPECT_EQ(Before.NumConstants - 2, After.NumConstants);
+  EXPECT_EQ(Head, ConstantDataArray::get(C, Bytes));
+}
+
+}  // end anonymous namespace
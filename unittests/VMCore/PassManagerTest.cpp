@@ -396,6 +396,34 @@ namespace llvm {
       delete M;
     }
 
+    static char DeferredID;
+    static unsigned DeferredInitCount;
+    static void initializeDeferred(PassRegistry &Registry) {
+      static PassInfo PI("deferred", "deferred", &DeferredID, 0, false, false);
+      ++DeferredInitCount;
+      Registry.registerPass(PI);
+    }
+
+    TEST(PassRegistry, DeferredInitializer) {
+      PassRegistry Registry;
+      Registry.registerDeferredInitializer(initializeDeferred);
+      EXPECT_EQ(0u, DeferredInitCount);
+
+      // Lookups by ID do not run deferred initializers.
+      EXPECT_EQ(0, Registry.getPassInfo(&DeferredID));
+      EXPECT_EQ(0u, DeferredInitCount);
+
+      // A lookup by name does, once.
+      const PassInfo *PI = Registry.getPassInfo(StringRef("deferred"));
+      ASSERT_TRUE(PI != 0);
+      EXPECT_EQ(&DeferredID, PI->getTypeInfo());
+      EXPECT_EQ(1u, DeferredInitCount);
+      EXPECT_EQ(PI, Registry.getPassInfo(&DeferredID));
+      EXPECT_EQ(0, Registry.getPassInfo(StringRef("unknown")));
+      Registry.runDeferredInitializers();
+      EXPECT_EQ(1u, DeferredInitCount);
+    }
+
     Module* makeLLVMModule() {
       // Module Construction
       Module* mod = new Module("test-mem", getGlobalContext());
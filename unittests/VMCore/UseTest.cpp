@@ -0,0 +1,83 @@
+//===- llvm/unittest/VMCore/UseTest.cpp - Use unit tests ------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Constants.h"
+#include "llvm/DerivedTypes.h"
+#include "llvm/Function.h"
+#include "llvm/GlobalVariable.h"
+#include "llvm/IRBuilder.h"
+#include "llvm/LLVMContext.h"
+#include "llvm/Module.h"
+#include "llvm/ADT/SmallVector.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+using namespace llvm;
+
+namespace {
+
+TEST(UseTest, ReplaceAllUsesWithOrder) {
+  LLVMContext C;
+  Module M("test", C);
+  Type *Int32Ty = Type::getInt32Ty(C);
+  Type *Params[] = { Int32Ty, Int32Ty };
+  Function *F = Function::Create(FunctionType::get(Int32Ty, Params, false),
+                                 GlobalValue::ExternalLinkage, "f", &M);
+  Function::arg_iterator AI = F->arg_begin();
+  Argument *A = AI++;
+  Argument *B = AI;
+
+  IRBuilder<> Builder(BasicBlock::Create(C, "entry", F));
+  Value *Existing = Builder.CreateAdd(B, B);
+  Value *Sum = Builder.getInt32(0);
+  for (unsigned i = 0; i != 8; ++i)
+    Sum = Builder.CreateAdd(Sum, A);
+  Builder.CreateRet(Builder.CreateAdd(Sum, Existing));
+
+  SmallVector<User*, 16> Expected(A->use_begin(), A->use_end());
+  std::reverse(Expected.begin(), Expected.end());
+  Expected.append(B->use_begin(), B->use_end());
+
+  A->replaceAllUsesWith(B);
+  EXPECT_TRUE(A->use_empty());
+  SmallVector<User*, 16> Actual(B->use_begin(), B->use_end());
+  EXPECT_TRUE(Expected == Actual);
+  for (Value::use_iterator UI = B->use_begin(), E = B->use_end(); UI != E;
+       ++UI)
+    EXPECT_EQ(B, UI.getUse().get());
+}
+
+TEST(UseTest, ReplaceAllUsesWithConstantUsers) {
+  LLVMContext C;
+  Module M("test", C);
+  Type *Int32Ty = Type::getInt32Ty(C);
+  GlobalVariable *G1 = new GlobalVariable(M, Int32Ty, false,
+                                          GlobalValue::ExternalLinkage, 0, "g1");
+  GlobalVariable *G2 = new GlobalVariable(M, Int32Ty, false,
+                                          GlobalValue::ExternalLinkage, 0, "g2");
+  Function *F = Function::Create(FunctionType::get(Int32Ty, false),
+                                 GlobalValue::ExternalLinkage, "f", &M);
+
+  // Mix instruction users of G1 with users through a constant expression.
+  IRBuilder<> Builder(BasicBlock::Create(C, "entry", F));
+  Value *L1 = Builder.CreateLoad(G1);
+  Constant *Cast = ConstantExpr::getPtrToInt(G1, Int32Ty);
+  Value *Add = Builder.CreateAdd(L1, Cast);
+  Value *L2 = Builder.CreateLoad(G1);
+  Builder.CreateRet(Builder.CreateAdd(Add, L2));
+
+  G1->replaceAllUsesWith(G2);
+  EXPECT_TRUE(G1->use_empty());
+  EXPECT_EQ(G2, cast<LoadInst>(L1)->getPointerOperand());
+  EXPECT_EQ(G2, cast<LoadInst>(L2)->getPointerOperand());
+  EXPECT_EQ(ConstantExpr::getPtrToInt(G2, Int32Ty),
+            cast<Instruction>(Add)->getOperand(1));
+  EXPECT_EQ(3, std::distance(G2->use_begin(), G2->use_end()));
+}
+
+}  // end anonymous namespace
@@ -60,5 +60,29 @@ TEST(VerifierTest, AliasUnnamedAddr) {
   EXPECT_TRUE(verifyModule(M, ReturnStatusAction, &Error));
   EXPECT_TRUE(StringRef(Error).startswith("Alias cannot have unnamed_addr"));
 }
+
+TEST(VerifierTest, StructuralLevel) {
+  LLVMContext &C = getGlobalContext();
+  Module M("M", C);
+  Type *Int32Ty = Type::getInt32Ty(C);
+  FunctionType *FTy = FunctionType::get(Int32Ty, Int32Ty, /*isVarArg=*/false);
+  Function *F = Function::Create(FTy, GlobalValue::ExternalLinkage, "f", &M);
+  BasicBlock *Entry = BasicBlock::Create(C, "entry", F);
+  BasicBlock *Exit = BasicBlock::Create(C, "exit", F);
+
+  // Use a value in the entry block which is only defined in the exit block.
+  Instruction *Def = BinaryOperator::CreateAdd(F->arg_begin(), F->arg_begin());
+  Instruction *Use = BinaryOperator::CreateAdd(Def, Def, "", Entry);
+  BranchInst::Create(Exit, Entry);
+  Exit->getInstList().push_back(Def);
+  ReturnInst::Create(C, Use, Exit);
+
+  EXPECT_TRUE(verifyFunction(*F, ReturnStatusAction));
+  EXPECT_FALSE(verifyFunction(*F, ReturnStatusAction,
+                              StructuralVerification));
+  EXPECT_TRUE(verifyModule(M, ReturnStatusAction));
+  EXPECT_FALSE(verifyModule(M, ReturnStatusAction, 0,
+                            StructuralVerification));
+}
 }
 }
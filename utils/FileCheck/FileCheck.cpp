@@ -24,6 +24,7 @@
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/Signals.h"
+#include "llvm/Support/Timer.h"
 #include "llvm/Support/system_error.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringMap.h"
@@ -45,10 +46,37 @@ static cl::opt<bool>
 NoCanonicalizeWhiteSpace("strict-whitespace",
               cl::desc("Do not treat all horizontal whitespace as equivalent"));
 
+static cl::opt<bool>
+TimeReport("time-report",
+           cl::desc("Print the time spent reading and checking the files"));
+
 //===----------------------------------------------------------------------===//
 // Pattern Handling Code.
 //===----------------------------------------------------------------------===//
 
+/// RegexCache - Compiled regular expressions by pattern string.  Check files
+/// often repeat the same pattern on many lines, and CHECK-NOT patterns are
+/// matched once for every range they guard, so compile each only once.
+class RegexCache {
+  StringMap<Regex*> Cache;
+
+public:
+  ~RegexCache() {
+    for (StringMap<Regex*>::iterator I = Cache.begin(), E = Cache.end();
+         I != E; ++I)
+      delete I->second;
+  }
+
+  Regex &get(StringRef RegExStr) {
+    Regex *&R = Cache[RegExStr];
+    if (!R)
+      R = new Regex(RegExStr, Regex::Newline);
+    return *R;
+  }
+};
+
+static RegexCache CompiledRegexes;
+
 class Pattern {
   SMLoc PatternLoc;
 
@@ -79,6 +107,10 @@ public:
 
   Pattern(bool matchEOF = false) : MatchEOF(matchEOF) { }
 
+  /// getFixedStr - Return the string this pattern matches if it is a fixed
+  /// string, or an empty string otherwise.
+  StringRef getFixedStr() const { return MatchEOF ? StringRef() : FixedStr; }
+
   bool ParsePattern(StringRef PatternStr, SourceMgr &SM);
 
   /// Match - Match the pattern string against the input buffer Buffer.  This
@@ -328,8 +360,13 @@ size_t Pattern::Match(StringRef Buffer, size_t &MatchLen,
   }
 
 
+  // Patterns with variable uses change from match to match, so only cache the
+  // ones without.
   SmallVector<StringRef, 4> MatchInfo;
-  if (!Regex(RegExToMatch, Regex::Newline).match(Buffer, &MatchInfo))
+  if (VariableUses.empty()) {
+    if (!CompiledRegexes.get(RegExToMatch).match(Buffer, &MatchInfo))
+      return StringRef::npos;
+  } else if (!Regex(RegExToMatch, Regex::Newline).match(Buffer, &MatchInfo))
     return StringRef::npos;
 
   // Successful regex match.
@@ -457,6 +494,202 @@ struct CheckString {
     : Pat(P), Loc(L), IsCheckNext(isCheckNext) {}
 };
 
+/// MultiStringMatcher - An Aho-Corasick automaton that finds the occurrences
+/// of any of a set of fixed strings in a single pass over the input.  Bytes
+/// are mapped to classes first, so the transition table only has a column for
+/// each distinct byte in the strings plus one for all other bytes.
+class MultiStringMatcher {
+  unsigned NumClasses;
+  unsigned char ByteClass[256];
+
+  /// Delta - The transition table, NumClasses entries per state.  State 0 is
+  /// the start state.
+  std::vector<unsigned> Delta;
+
+  /// Match - The index of the string that ends at each state, or -1.
+  std::vector<int> Match;
+
+  /// OutLink - The next state along the failure chain that has a Match, or 0.
+  std::vector<unsigned> OutLink;
+
+  unsigned addState() {
+    Delta.resize(Delta.size() + NumClasses);
+    Match.push_back(-1);
+    OutLink.push_back(0);
+    return Match.size() - 1;
+  }
+
+public:
+  /// MultiStringMatcher - Build the automaton for the non-empty Strings.  If a
+  /// string appears more than once, the lowest index is reported.
+  explicit MultiStringMatcher(ArrayRef<StringRef> Strings) : NumClasses(1) {
+    memset(ByteClass, 0, sizeof(ByteClass));
+    for (unsigned i = 0, e = Strings.size(); i != e; ++i)
+      for (unsigned j = 0, je = Strings[i].size(); j != je; ++j) {
+        unsigned char &C = ByteClass[(unsigned char)Strings[i][j]];
+        if (!C)
+          C = NumClasses++;
+      }
+
+    // Build the trie.  A zero transition is a missing edge for now, which is
+    // unambiguous because no edge leads back to the start state.
+    addState();
+    for (unsigned i = 0, e = Strings.size(); i != e; ++i) {
+      assert(!Strings[i].empty() && "Cannot match an empty string");
+      unsigned S = 0;
+      for (unsigned j = 0, je = Strings[i].size(); j != je; ++j) {
+        unsigned C = ByteClass[(unsigned char)Strings[i][j]];
+        unsigned Next = Delta[S * NumClasses + C];
+        if (!Next) {
+          Next = addState();
+          Delta[S * NumClasses + C] = Next;
+        }
+        S = Next;
+      }
+      if (Match[S] == -1)
+        Match[S] = i;
+    }
+
+    // Turn it into a DFA breadth first: a missing edge goes where the edge
+    // from the failure state goes, which is already complete.
+    std::vector<unsigned> Fail(Match.size(), 0), Queue;
+    for (unsigned C = 0; C != NumClasses; ++C)
+      if (unsigned T = Delta[C])
+        Queue.push_back(T);
+    for (unsigned Q = 0; Q != Queue.size(); ++Q) {
+      unsigned S = Queue[Q], F = Fail[S];
+      OutLink[S] = Match[F] != -1 ? F : OutLink[F];
+      for (unsigned C = 0; C != NumClasses; ++C) {
+        unsigned &T = Delta[S * NumClasses + C];
+        if (T) {
+          Fail[T] = Delta[F * NumClasses + C];
+          Queue.push_back(T);
+        } else {
+          T = Delta[F * NumClasses + C];
+        }
+      }
+    }
+  }
+
+  /// scan - Call Handler(Index, End) for every occurrence of a string in
+  /// Buffer, in order of End, the offset just past the occurrence.  Stop when
+  /// the handler returns true.
+  template<typename HandlerT>
+  void scan(StringRef Buffer, HandlerT &Handler) const {
+    unsigned S = 0;
+    for (size_t i = 0, e = Buffer.size(); i != e; ++i) {
+      S = Delta[S * NumClasses + ByteClass[(unsigned char)Buffer[i]]];
+      for (unsigned M = Match[S] != -1 ? S : OutLink[S]; M; M = OutLink[M])
+        if (Handler(unsigned(Match[M]), i + 1))
+          return;
+    }
+  }
+};
+
+/// CheckScanner - The handler for scanning the input for a check.  String
+/// Target is the check's own pattern; the others are its fixed "not strings",
+/// for which the first occurrence is recorded.
+struct CheckScanner {
+  ArrayRef<StringRef> Strings;
+  unsigned Target;
+  size_t TargetPos;
+  std::vector<size_t> FirstPos;
+
+  CheckScanner(ArrayRef<StringRef> strings, unsigned target)
+    : Strings(strings), Target(target), TargetPos(StringRef::npos),
+      FirstPos(strings.size(), StringRef::npos) {}
+
+  bool operator()(unsigned Index, size_t End) {
+    if (Index == Target) {
+      TargetPos = End - Strings[Index].size();
+      return true;
+    }
+    if (FirstPos[Index] == StringRef::npos)
+      FirstPos[Index] = End - Strings[Index].size();
+    return false;
+  }
+};
+
+/// MatchCheckString - Find the match for CheckStr in Buffer like
+/// Pattern::Match, then check whether any of its "not strings" occur before
+/// it.  If one does, return its index in NotNo and its offset in NotPos,
+/// otherwise set NotPos to npos.
+///
+/// All fixed strings among the pattern and the "not strings" are found with
+/// one pass over the input, rather than a pass per string over the region
+/// before the match.
+static size_t MatchCheckString(const CheckString &CheckStr, StringRef Buffer,
+                               size_t &MatchLen,
+                               StringMap<StringRef> &VariableTable,
+                               unsigned &NotNo, size_t &NotPos) {
+  const std::vector<std::pair<SMLoc, Pattern> > &NotStrings =
+    CheckStr.NotStrings;
+  NotPos = StringRef::npos;
+
+  // Collect the fixed strings.  The pattern's own string goes first so that
+  // it wins over an identical "not string", which cannot occur before it.
+  SmallVector<StringRef, 8> Fixed;
+  SmallVector<unsigned, 8> FixedNo(NotStrings.size(), ~0U);
+  unsigned Target = ~0U;
+  if (!CheckStr.Pat.getFixedStr().empty()) {
+    Target = Fixed.size();
+    Fixed.push_back(CheckStr.Pat.getFixedStr());
+  }
+  for (unsigned i = 0, e = NotStrings.size(); i != e; ++i)
+    if (!NotStrings[i].second.getFixedStr().empty()) {
+      FixedNo[i] = Fixed.size();
+      Fixed.push_back(NotStrings[i].second.getFixedStr());
+    }
+
+  // With at most one string there is nothing to share; search for each one
+  // separately.
+  size_t MatchPos;
+  CheckScanner Scanner(Fixed, Target);
+  if (Fixed.size() < 2) {
+    MatchPos = CheckStr.Pat.Match(Buffer, MatchLen, VariableTable);
+    if (MatchPos == StringRef::npos)
+      return MatchPos;
+    FixedNo.assign(NotStrings.size(), ~0U);
+  } else {
+    MultiStringMatcher Matcher(Fixed);
+    if (Target != ~0U) {
+      // Scan until the first occurrence of the pattern.
+      Matcher.scan(Buffer, Scanner);
+      MatchPos = Scanner.TargetPos;
+      MatchLen = Fixed[Target].size();
+      if (MatchPos == StringRef::npos)
+        return MatchPos;
+    } else {
+      // Match the pattern on its own, then scan the region before it.
+      MatchPos = CheckStr.Pat.Match(Buffer, MatchLen, VariableTable);
+      if (MatchPos == StringRef::npos)
+        return MatchPos;
+      Matcher.scan(Buffer.substr(0, MatchPos), Scanner);
+    }
+  }
+
+  // Report the first "not string" that occurs, in the order they were
+  // written.  Fixed ones are only found if they end before the match starts.
+  StringRef SkippedRegion = Buffer.substr(0, MatchPos);
+  for (unsigned i = 0, e = NotStrings.size(); i != e; ++i) {
+    size_t Pos;
+    if (FixedNo[i] != ~0U) {
+      Pos = Scanner.FirstPos[FixedNo[i]];
+      if (Pos != StringRef::npos && Pos + Fixed[FixedNo[i]].size() > MatchPos)
+        Pos = StringRef::npos;
+    } else {
+      size_t NotLen = 0;
+      Pos = NotStrings[i].second.Match(SkippedRegion, NotLen, VariableTable);
+    }
+    if (Pos != StringRef::npos) {
+      NotNo = i;
+      NotPos = Pos;
+      break;
+    }
+  }
+  return MatchPos;
+}
+
 /// CanonicalizeInputFile - Remove duplicate horizontal space from the specified
 /// memory buffer, free it, and return a new one.
 static MemoryBuffer *CanonicalizeInputFile(MemoryBuffer *MB) {
@@ -650,12 +883,21 @@ int main(int argc, char **argv) {
   PrettyStackTraceProgram X(argc, argv);
   cl::ParseCommandLineOptions(argc, argv);
 
+  // With -time-report, the times are printed when the timers go away.
+  TimerGroup TG("FileCheck: " + CheckFilename);
+  Timer ReadTimer("Read check file", TG), MatchTimer("Check input", TG);
+
   SourceMgr SM;
 
   // Read the expected strings from the check file.
   std::vector<CheckString> CheckStrings;
-  if (ReadCheckFile(SM, CheckStrings))
-    return 2;
+  {
+    TimeRegion T(TimeReport ? &ReadTimer : 0);
+    if (ReadCheckFile(SM, CheckStrings))
+      return 2;
+  }
+
+  TimeRegion T(TimeReport ? &MatchTimer : 0);
 
   // Open the file to check and add it to SourceMgr.
   OwningPtr<MemoryBuffer> File;
@@ -692,9 +934,12 @@ int main(int argc, char **argv) {
 
     StringRef SearchFrom = Buffer;
 
-    // Find StrNo in the file.
-    size_t MatchLen = 0;
-    size_t MatchPos = CheckStr.Pat.Match(Buffer, MatchLen, VariableTable);
+    // Find StrNo in the file, and the first of its "not strings" that occurs
+    // before it.
+    size_t MatchLen = 0, NotPos;
+    unsigned NotNo = 0;
+    size_t MatchPos = MatchCheckString(CheckStr, Buffer, MatchLen,
+                                       VariableTable, NotNo, NotPos);
     Buffer = Buffer.substr(MatchPos);
 
     // If we didn't find a match, reject the input.
@@ -736,17 +981,11 @@ int main(int argc, char **argv) {
 
     // If this match had "not strings", verify that they don't exist in the
     // skipped region.
-    for (unsigned ChunkNo = 0, e = CheckStr.NotStrings.size();
-         ChunkNo != e; ++ChunkNo) {
-      size_t MatchLen = 0;
-      size_t Pos = CheckStr.NotStrings[ChunkNo].second.Match(SkippedRegion,
-                                                             MatchLen,
-                                                             VariableTable);
-      if (Pos == StringRef::npos) continue;
-
-      SM.PrintMessage(SMLoc::getFromPointer(LastMatch+Pos), SourceMgr::DK_Error,
+    if (NotPos != StringRef::npos) {
+      SM.PrintMessage(SMLoc::getFromPointer(LastMatch+NotPos),
+                      SourceMgr::DK_Error,
                       CheckPrefix+"-NOT: string occurred!");
-      SM.PrintMessage(CheckStr.NotStrings[ChunkNo].first, SourceMgr::DK_Note,
+      SM.PrintMessage(CheckStr.NotStrings[NotNo].first, SourceMgr::DK_Note,
                       CheckPrefix+"-NOT: pattern specified here");
       return 1;
     }
@@ -0,0 +1,575 @@
+//===- ADTBench - Benchmark the ADT and Support containers ----------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This program measures the insert, lookup, iteration and erase throughput and
+// the memory footprint of the ADT containers for a range of sizes, and prints
+// the results as CSV or JSON.  SourceMgr is measured the same way, as a
+// container of source lines.
+//
+// For every container and size, enough containers are filled that each
+// measurement covers about -elements operations, so that small sizes are
+// timed as accurately as large ones.  The best of -repeat runs is reported.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/FlatSparseBitVector.h"
+#include "llvm/ADT/FoldingSet.h"
+#include "llvm/ADT/GroupHashMap.h"
+#include "llvm/ADT/ImmutableSet.h"
+#include "llvm/ADT/IntervalMap.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/SparseBitVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/Twine.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/TimeValue.h"
+#include "llvm/Support/raw_ostream.h"
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+static cl::list<unsigned>
+Sizes("sizes", cl::CommaSeparated,
+      cl::desc("Container sizes to measure (default 16,256,4096,65536)"));
+
+static cl::opt<unsigned>
+Elements("elements", cl::init(1 << 20),
+         cl::desc("Number of operations per measurement"));
+
+static cl::opt<unsigned>
+Repeat("repeat", cl::init(3),
+       cl::desc("Number of runs; the fastest one is reported"));
+
+static cl::opt<std::string>
+Filter("filter", cl::desc("Only measure containers whose name contains this"));
+
+enum OutputFormatTy { CSV, JSON };
+static cl::opt<OutputFormatTy>
+OutputFormat("format", cl::desc("Output format"), cl::init(CSV),
+             cl::values(clEnumValN(CSV, "csv", "Comma separated values"),
+                        clEnumValN(JSON, "json", "A JSON array of objects"),
+                        clEnumValEnd));
+
+/// Sink - Results of lookups and iterations are accumulated here so that the
+/// work cannot be optimized away.
+static volatile unsigned Sink;
+
+namespace {
+
+enum {
+  OpInsert  = 1 << 0,
+  OpLookup  = 1 << 1,
+  OpIterate = 1 << 2,
+  OpErase   = 1 << 3,
+  NumOps    = 4
+};
+
+static const char *const OpNames[NumOps] = {
+  "insert", "lookup", "iterate", "erase"
+};
+
+/// KeySet - N distinct keys in a random order, the same keys in another order
+/// for lookups, and string and pointer versions of them.
+struct KeySet {
+  std::vector<unsigned> Keys, LookupKeys;
+  std::vector<std::string> Strings;
+  std::vector<void*> Pointers;
+
+  explicit KeySet(unsigned N) {
+    for (unsigned i = 0; i != N; ++i)
+      Keys.push_back(1 + i * 7);
+    shuffle(Keys, 1);
+    LookupKeys = Keys;
+    shuffle(LookupKeys, 2);
+    for (unsigned i = 0; i != N; ++i) {
+      Strings.push_back(("key" + Twine(Keys[i])).str());
+      Pointers.push_back(reinterpret_cast<void*>(uintptr_t(Keys[i]) << 3));
+    }
+  }
+
+  /// shuffle - A deterministic Fisher-Yates shuffle.
+  static void shuffle(std::vector<unsigned> &V, unsigned Seed) {
+    uint64_t State = Seed;
+    for (unsigned i = V.size(); i > 1; --i) {
+      State = State * 6364136223846793005ULL + 1442695040888963407ULL;
+      std::swap(V[i - 1], V[(State >> 33) % i]);
+    }
+  }
+};
+
+//===----------------------------------------------------------------------===//
+// Containers
+//===----------------------------------------------------------------------===//
+//
+// Each benchmark class holds one container, names the operations it supports,
+// and implements them over a KeySet.
+
+struct SmallVectorBench {
+  static const char *getName() { return "SmallVector"; }
+  enum { Ops = OpInsert | OpIterate | OpErase };
+  SmallVector<unsigned, 16> V;
+
+  void insert(const KeySet &K) {
+    for (unsigned i = 0, e = K.Keys.size(); i != e; ++i)
+      V.push_back(K.Keys[i]);
+  }
+  unsigned lookup(const KeySet &) { return 0; }
+  unsigned iterate() {
+    unsigned Sum = 0;
+    for (SmallVectorImpl<unsigned>::iterator I = V.begin(), E = V.end();
+         I != E; ++I)
+      Sum += *I;
+    return Sum;
+  }
+  void erase(const KeySet &) {
+    while (!V.empty())
+      V.pop_back();
+  }
+};
+
+template<typename MapT>
+struct UnsignedMapBench {
+  enum { Ops = OpInsert | OpLookup | OpIterate | OpErase };
+  MapT M;
+
+  void insert(const KeySet &K) {
+    for (unsigned i = 0, e = K.Keys.size(); i != e; ++i)
+      M.insert(std::make_pair(K.Keys[i], i));
+  }
+  unsigned lookup(const KeySet &K) {
+    unsigned Found = 0;
+    for (unsigned i = 0, e = K.LookupKeys.size(); i != e; ++i)
+      Found += M.count(K.LookupKeys[i]);
+    return Found;
+  }
+  unsigned iterate() {
+    unsigned Sum = 0;
+    for (typename MapT::iterator I = M.begin(), E = M.end(); I != E; ++I)
+      Sum += I->second;
+    return Sum;
+  }
+  void erase(const KeySet &K) {
+    for (unsigned i = 0, e = K.Keys.size(); i != e; ++i)
+      M.erase(K.Keys[i]);
+  }
+};
+
+struct DenseMapBench : UnsignedMapBench<DenseMap<unsigned, unsigned> > {
+  static const char *getName() { return "DenseMap"; }
+};
+
+struct GroupHashMapBench : UnsignedMapBench<GroupHashMap<unsigned, unsigned> > {
+  static const char *getName() { return "GroupHashMap"; }
+};
+
+struct StringMapBench {
+  static const char *getName() { return "StringMap"; }
+  enum { Ops = OpInsert | OpLookup | OpIterate | OpErase };
+  StringMap<unsigned> M;
+
+  void insert(const KeySet &K) {
+    for (unsigned i = 0, e = K.Strings.size(); i != e; ++i)
+      M.GetOrCreateValue(K.Strings[i], i);
+  }
+  unsigned lookup(const KeySet &K) {
+    // Look the strings up in a different order than they were inserted.
+    unsigned Found = 0, N = K.Strings.size();
+    for (unsigned i = 0; i != N; ++i)
+      Found += M.count(K.Strings[K.LookupKeys[i] / 7 % N]);
+    return Found;
+  }
+  unsigned iterate() {
+    unsigned Sum = 0;
+    for (StringMap<unsigned>::iterator I = M.begin(), E = M.end(); I != E; ++I)
+      Sum += I->getValue();
+    return Sum;
+  }
+  void erase(const KeySet &K) {
+    for (unsigned i = 0, e = K.Strings.size(); i != e; ++i)
+      M.erase(K.Strings[i]);
+  }
+};
+
+struct SmallPtrSetBench {
+  static const char *getName() { return "SmallPtrSet"; }
+  enum { Ops = OpInsert | OpLookup | OpIterate | OpErase };
+  SmallPtrSet<void*, 16> S;
+
+  void insert(const KeySet &K) {
+    for (unsigned i = 0, e = K.Pointers.size(); i != e; ++i)
+      S.insert(K.Pointers[i]);
+  }
+  unsigned lookup(const KeySet &K) {
+    unsigned Found = 0;
+    for (unsigned i = 0, e = K.LookupKeys.size(); i != e; ++i)
+      Found += S.count(reinterpret_cast<void*>(uintptr_t(K.LookupKeys[i]) << 3));
+    return Found;
+  }
+  unsigned iterate() {
+    unsigned Sum = 0;
+    for (SmallPtrSet<void*, 16>::iterator I = S.begin(), E = S.end(); I != E;
+         ++I)
+      Sum += unsigned(uintptr_t(*I));
+    return Sum;
+  }
+  void erase(const KeySet &K) {
+    for (unsigned i = 0, e = K.Pointers.size(); i != e; ++i)
+      S.erase(K.Pointers[i]);
+  }
+};
+
+struct FoldingSetBench {
+  static const char *getName() { return "FoldingSet"; }
+  enum { Ops = OpInsert | OpLookup | OpIterate | OpErase };
+
+  struct Node : public FoldingSetNode {
+    unsigned Value;
+    void Profile(FoldingSetNodeID &ID) const { ID.AddInteger(Value); }
+  };
+  std::vector<Node> Nodes;
+  FoldingSet<Node> S;
+
+  void insert(const KeySet &K) {
+    Nodes.resize(K.Keys.size());
+    for (unsigned i = 0, e = K.Keys.size(); i != e; ++i) {
+      Nodes[i].Value = K.Keys[i];
+      S.GetOrInsertNode(&Nodes[i]);
+    }
+  }
+  unsigned lookup(const KeySet &K) {
+    unsigned Found = 0;
+    for (unsigned i = 0, e = K.LookupKeys.size(); i != e; ++i) {
+      FoldingSetNodeID ID;
+      ID.AddInteger(K.LookupKeys[i]);
+      void *InsertPos;
+      Found += S.FindNodeOrInsertPos(ID, InsertPos) != 0;
+    }
+    return Found;
+  }
+  unsigned iterate() {
+    unsigned Sum = 0;
+    for (FoldingSet<Node>::iterator I = S.begin(), E = S.end(); I != E; ++I)
+      Sum += I->Value;
+    return Sum;
+  }
+  void erase(const KeySet &) {
+    for (unsigned i = 0, e = Nodes.size(); i != e; ++i)
+      S.RemoveNode(&Nodes[i]);
+  }
+};
+
+template <typename SetT>
+struct BitSetBench {
+  enum { Ops = OpInsert | OpLookup | OpIterate | OpErase };
+  SetT V;
+
+  void insert(const KeySet &K) {
+    for (unsigned i = 0, e = K.Keys.size(); i != e; ++i)
+      V.set(K.Keys[i]);
+  }
+  unsigned lookup(const KeySet &K) {
+    unsigned Found = 0;
+    for (unsigned i = 0, e = K.LookupKeys.size(); i != e; ++i)
+      Found += V.test(K.LookupKeys[i]);
+    return Found;
+  }
+  unsigned iterate() {
+    unsigned Sum = 0;
+    for (typename SetT::iterator I = V.begin(), E = V.end(); I != E; ++I)
+      Sum += *I;
+    return Sum;
+  }
+  void erase(const KeySet &K) {
+    for (unsigned i = 0, e = K.Keys.size(); i != e; ++i)
+      V.reset(K.Keys[i]);
+  }
+};
+
+struct SparseBitVectorBench : BitSetBench<SparseBitVector<> > {
+  static const char *getName() { return "SparseBitVector"; }
+};
+
+struct FlatSparseBitVectorBench : BitSetBench<FlatSparseBitVector<> > {
+  static const char *getName() { return "FlatSparseBitVector"; }
+};
+
+struct IntervalMapBench {
+  static const char *getName() { return "IntervalMap"; }
+  enum { Ops = OpInsert | OpLookup | OpIterate | OpErase };
+  typedef IntervalMap<unsigned, unsigned> MapT;
+  MapT::Allocator Alloc;
+  MapT M;
+
+  IntervalMapBench() : M(Alloc) {}
+
+  void insert(const KeySet &K) {
+    // Keys are 7 apart, so these intervals never coalesce.
+    for (unsigned i = 0, e = K.Keys.size(); i != e; ++i)
+      M.insert(K.Keys[i], K.Keys[i] + 1, i);
+  }
+  unsigned lookup(const KeySet &K) {
+    unsigned Sum = 0;
+    for (unsigned i = 0, e = K.LookupKeys.size(); i != e; ++i)
+      Sum += M.lookup(K.LookupKeys[i]);
+    return Sum;
+  }
+  unsigned iterate() {
+    unsigned Sum = 0;
+    for (MapT::const_iterator I = M.begin(); I.valid(); ++I)
+      Sum += I.value();
+    return Sum;
+  }
+  void erase(const KeySet &K) {
+    for (unsigned i = 0, e = K.Keys.size(); i != e; ++i) {
+      MapT::iterator I = M.find(K.Keys[i]);
+      I.erase();
+    }
+  }
+};
+
+struct ImmutableSetBench {
+  static const char *getName() { return "ImmutableSet"; }
+  enum { Ops = OpInsert | OpLookup | OpIterate | OpErase };
+  ImmutableSet<unsigned>::Factory F;
+  ImmutableSet<unsigned> S;
+
+  ImmutableSetBench() : S(F.getEmptySet()) {}
+
+  void insert(const KeySet &K) {
+    for (unsigned i = 0, e = K.Keys.size(); i != e; ++i)
+      S = F.add(S, K.Keys[i]);
+  }
+  unsigned lookup(const KeySet &K) {
+    unsigned Found = 0;
+    for (unsigned i = 0, e = K.LookupKeys.size(); i != e; ++i)
+      Found += S.contains(K.LookupKeys[i]);
+    return Found;
+  }
+  unsigned iterate() {
+    unsigned Sum = 0;
+    for (ImmutableSet<unsigned>::iterator I = S.begin(), E = S.end(); I != E;
+         ++I)
+      Sum += *I;
+    return Sum;
+  }
+  void erase(const KeySet &K) {
+    for (unsigned i = 0, e = K.Keys.size(); i != e; ++i)
+      S = F.remove(S, K.Keys[i]);
+  }
+};
+
+struct BumpPtrAllocatorBench {
+  static const char *getName() { return "BumpPtrAllocator"; }
+  // Insert is a 16 byte allocation per key, and erase is a Reset().
+  enum { Ops = OpInsert | OpErase };
+  BumpPtrAllocator A;
+
+  void insert(const KeySet &K) {
+    for (unsigned i = 0, e = K.Keys.size(); i != e; ++i)
+      *static_cast<unsigned*>(A.Allocate(16, 8)) = K.Keys[i];
+  }
+  unsigned lookup(const KeySet &) { return 0; }
+  unsigned iterate() { return 0; }
+  void erase(const KeySet &) { A.Reset(); }
+};
+
+struct SourceMgrBench {
+  static const char *getName() { return "SourceMgr"; }
+  // Insert builds an assembly-like buffer with a line per key.  Lookup finds
+  // the line and column of locations in the last eighth of the buffer in a
+  // random order, as diagnostics near the end of a large file would.
+  enum { Ops = OpInsert | OpLookup };
+  SourceMgr SM;
+  std::vector<const char*> Lines;
+
+  void insert(const KeySet &K) {
+    std::string Text;
+    std::vector<size_t> Offsets;
+    for (unsigned i = 0, e = K.Keys.size(); i != e; ++i) {
+      Offsets.push_back(Text.size());
+      Text += ("\tmovl\t$" + Twine(K.Keys[i]) + ", %eax\n").str();
+    }
+    MemoryBuffer *Buf = MemoryBuffer::getMemBufferCopy(Text, "<bench>");
+    SM.AddNewSourceBuffer(Buf, SMLoc());
+    for (unsigned i = 0, e = Offsets.size(); i != e; ++i)
+      Lines.push_back(Buf->getBufferStart() + Offsets[i]);
+  }
+  unsigned lookup(const KeySet &K) {
+    unsigned Sum = 0, Size = Lines.size(), Tail = std::max(1U, Size / 8);
+    for (unsigned i = 0; i != Size; ++i) {
+      const char *Ptr = Lines[Size - 1 - K.LookupKeys[i] % Tail] + 1;
+      Sum += SM.getLineAndColumn(SMLoc::getFromPointer(Ptr), 0).first;
+    }
+    return Sum;
+  }
+  unsigned iterate() { return 0; }
+  void erase(const KeySet &) {}
+};
+
+//===----------------------------------------------------------------------===//
+// Harness
+//===----------------------------------------------------------------------===//
+
+/// Result - The measurements for one container at one size.
+struct Result {
+  const char *Container;
+  unsigned Size;
+  unsigned Ops;
+  double NsPerOp[NumOps];
+  double BytesPerContainer;
+};
+
+static double getWallTimeInNs() {
+  sys::TimeValue Now = sys::TimeValue::now();
+  return Now.seconds() * 1e9 + Now.nanoseconds();
+}
+
+template<typename BenchT>
+static Result runBenchmark(const KeySet &K) {
+  unsigned Size = K.Keys.size();
+  unsigned NumContainers = std::max(1U, Elements / std::max(1U, Size));
+  double Ops = double(NumContainers) * Size;
+
+  Result R;
+  R.Container = BenchT::getName();
+  R.Size = Size;
+  R.Ops = BenchT::Ops;
+  for (unsigned Op = 0; Op != NumOps; ++Op)
+    R.NsPerOp[Op] = 0;
+  R.BytesPerContainer = 0;
+
+  std::vector<BenchT*> Benches(NumContainers);
+  for (unsigned Run = 0; Run != std::max(1U, unsigned(Repeat)); ++Run) {
+    double Times[NumOps];
+    size_t MallocBefore = sys::Process::GetMallocUsage();
+    for (unsigned i = 0; i != NumContainers; ++i)
+      Benches[i] = new BenchT();
+
+    double Start = getWallTimeInNs();
+    for (unsigned i = 0; i != NumContainers; ++i)
+      Benches[i]->insert(K);
+    Times[0] = getWallTimeInNs() - Start;
+    size_t MallocAfter = sys::Process::GetMallocUsage();
+
+    unsigned Acc = 0;
+    Start = getWallTimeInNs();
+    if (BenchT::Ops & OpLookup)
+      for (unsigned i = 0; i != NumContainers; ++i)
+        Acc += Benches[i]->lookup(K);
+    Times[1] = getWallTimeInNs() - Start;
+
+    Start = getWallTimeInNs();
+    if (BenchT::Ops & OpIterate)
+      for (unsigned i = 0; i != NumContainers; ++i)
+        Acc += Benches[i]->iterate();
+    Times[2] = getWallTimeInNs() - Start;
+
+    Start = getWallTimeInNs();
+    for (unsigned i = 0; i != NumContainers; ++i)
+      Benches[i]->erase(K);
+    Times[3] = getWallTimeInNs() - Start;
+    Sink += Acc;
+
+    for (unsigned i = 0; i != NumContainers; ++i)
+      delete Benches[i];
+
+    for (unsigned Op = 0; Op != NumOps; ++Op)
+      if (Run == 0 || Times[Op] / Ops < R.NsPerOp[Op])
+        R.NsPerOp[Op] = Times[Op] / Ops;
+    if (Run == 0 && MallocAfter > MallocBefore)
+      R.BytesPerContainer = double(MallocAfter - MallocBefore) / NumContainers;
+  }
+  return R;
+}
+
+static void printCSV(const std::vector<Result> &Results) {
+  outs() << "container,size";
+  for (unsigned Op = 0; Op != NumOps; ++Op)
+    outs() << ',' << OpNames[Op] << "_ns";
+  outs() << ",bytes\n";
+  for (unsigned i = 0, e = Results.size(); i != e; ++i) {
+    const Result &R = Results[i];
+    outs() << R.Container << ',' << R.Size;
+    for (unsigned Op = 0; Op != NumOps; ++Op) {
+      outs() << ',';
+      if (R.Ops & (1 << Op))
+        outs() << format("%.3f", R.NsPerOp[Op]);
+    }
+    outs() << ',' << format("%.0f", R.BytesPerContainer) << '\n';
+  }
+}
+
+static void printJSON(const std::vector<Result> &Results) {
+  outs() << "[";
+  for (unsigned i = 0, e = Results.size(); i != e; ++i) {
+    const Result &R = Results[i];
+    outs() << (i ? ",\n  " : "\n  ")
+           << "{ \"container\": \"" << R.Container << "\", \"size\": "
+           << R.Size;
+    for (unsigned Op = 0; Op != NumOps; ++Op)
+      if (R.Ops & (1 << Op))
+        outs() << ", \"" << OpNames[Op] << "_ns\": "
+               << format("%.3f", R.NsPerOp[Op]);
+    outs() << ", \"bytes\": " << format("%.0f", R.BytesPerContainer) << " }";
+  }
+  outs() << "\n]\n";
+}
+
+} // end anonymous namespace
+
+template<typename BenchT>
+static void addBenchmark(std::vector<Result> &Results, const KeySet &K) {
+  if (!Filter.empty() &&
+      StringRef(BenchT::getName()).find(Filter) == StringRef::npos)
+    return;
+  Results.push_back(runBenchmark<BenchT>(K));
+}
+
+int main(int argc, char **argv) {
+  cl::ParseCommandLineOptions(argc, argv, "ADT container benchmark\n");
+
+  std::vector<unsigned> SizeList(Sizes.begin(), Sizes.end());
+  if (SizeList.empty()) {
+    SizeList.push_back(16);
+    SizeList.push_back(256);
+    SizeList.push_back(4096);
+    SizeList.push_back(65536);
+  }
+
+  std::vector<Result> Results;
+  for (unsigned i = 0, e = SizeList.size(); i != e; ++i) {
+    KeySet K(SizeList[i]);
+    addBenchmark<SmallVectorBench>(Results, K);
+    addBenchmark<DenseMapBench>(Results, K);
+    addBenchmark<GroupHashMapBench>(Results, K);
+    addBenchmark<StringMapBench>(Results, K);
+    addBenchmark<SmallPtrSetBench>(Results, K);
+    addBenchmark<FoldingSetBench>(Results, K);
+    addBenchmark<SparseBitVectorBench>(Results, K);
+    addBenchmark<FlatSparseBitVectorBench>(Results, K);
+    addBenchmark<IntervalMapBench>(Results, K);
+    addBenchmark<ImmutableSetBench>(Results, K);
+    addBenchmark<BumpPtrAllocatorBench>(Results, K);
+    addBenchmark<SourceMgrBench>(Results, K);
+  }
+
+  if (OutputFormat == JSON)
+    printJSON(Results);
+  else
+    printCSV(Results);
+  return 0;
+}